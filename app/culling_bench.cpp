@@ -0,0 +1,67 @@
+#include <rise/rendering/llgl/culling.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+using namespace rise::rendering;
+
+// отбор 100k боксов: пакетный cullAabbs против testAabb по одному боксу
+int main() {
+    constexpr size_t count = 100000;
+    constexpr int runs = 50;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+
+    std::vector<Aabb> boxes(count);
+    CullBatch batch;
+    batch.resize(count);
+    for (size_t i = 0; i != count; ++i) {
+        glm::vec3 center{position(random), position(random), position(random)};
+        glm::vec3 extent{size(random), size(random), size(random)};
+        boxes[i] = {center - extent, center + extent};
+        batch.set(i, boxes[i]);
+    }
+
+    auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 10.0f, 0.1f, 300.0f);
+    auto view = glm::lookAt(glm::vec3(0, 10, -50), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+    auto frustum = extractFrustum(projection * view);
+
+    using Clock = std::chrono::steady_clock;
+    auto best = [](auto &&f) {
+        double result = 1e30;
+        for (int run = 0; run != runs; ++run) {
+            auto start = Clock::now();
+            f();
+            result = std::min(result,
+                    std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        return result;
+    };
+
+    std::vector<uint8_t> single(count);
+    double singleTime = best([&] {
+        for (size_t i = 0; i != count; ++i) {
+            single[i] = testAabb(frustum, boxes[i]);
+        }
+    });
+    double batchTime = best([&] {
+        batch.cull(frustum, 0, count);
+    });
+
+    size_t visible = 0;
+    for (size_t i = 0; i != count; ++i) {
+        if (single[i] != batch.visible[i]) {
+            std::printf("mismatch at box %zu\n", i);
+            return 1;
+        }
+        visible += single[i];
+    }
+
+    std::printf("boxes: %zu, visible: %zu\n", count, visible);
+    std::printf("testAabb:  %8.1f us, %5.2f ns/box\n", singleTime, singleTime * 1000 / count);
+    std::printf("cullAabbs: %8.1f us, %5.2f ns/box\n", batchTime, batchTime * 1000 / count);
+    return 0;
+}
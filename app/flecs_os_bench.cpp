@@ -0,0 +1,92 @@
+#include <rise/util/flecs_os.hpp>
+#include <flecs.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+struct Position {
+    float x, y, z;
+};
+
+struct Velocity {
+    float x, y, z;
+};
+
+struct Counter {
+    int value;
+};
+
+// нагрузка на синхронизацию многопоточного конвейера flecs: много коротких систем, после
+// каждой рабочие потоки встречаются на барьере шима. Аргумент - число попыток захвата
+// мьютекса до парковки потока (stdcpp_set_os_api), 0 - парковка сразу
+int main(int argc, char **argv) {
+    int spinCount = argc > 1 ? std::atoi(argv[1]) : 100;
+    const int entities = 50000;
+    const int systems = 16;
+    const int warmup = 50;
+    const int frames = 500;
+
+    stdcpp_set_os_api(spinCount);
+
+    std::vector<int32_t> threadCounts{1, 2, 4};
+    auto hardware = static_cast<int32_t>(std::max(1u, std::thread::hardware_concurrency()));
+    if (std::find(threadCounts.begin(), threadCounts.end(), hardware) == threadCounts.end()) {
+        threadCounts.push_back(hardware);
+    }
+
+    std::printf("spin count: %d, entities: %d, systems: %d\n", spinCount, entities, systems);
+    for (auto threads : threadCounts) {
+        flecs::world ecs;
+        ecs.component<Position>("Position");
+        ecs.component<Velocity>("Velocity");
+        ecs.component<Counter>("Counter");
+
+        for (int i = 0; i != systems; ++i) {
+            ecs.system<Position, const Velocity>().each(
+                    [](flecs::entity e, Position &p, Velocity const &v) {
+                        p.x += v.x * e.delta_time();
+                        p.y += v.y * e.delta_time();
+                        p.z += v.z * e.delta_time();
+                    });
+        }
+        ecs.system<Counter>().each([](flecs::entity, Counter &c) {
+            ++c.value;
+        });
+
+        for (int i = 0; i != entities; ++i) {
+            ecs.entity().
+                    set<Position>({float(i), 0, 0}).
+                    set<Velocity>({1, 0.5f, 0.25f}).
+                    set<Counter>({0});
+        }
+
+        ecs.set_threads(threads);
+        for (int i = 0; i != warmup; ++i) {
+            ecs.progress(1.0f / 60);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i != frames; ++i) {
+            ecs.progress(1.0f / 60);
+        }
+        double us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count() / frames;
+
+        // каждая сущность обработана в каждом кадре ровно один раз
+        bool valid = true;
+        auto counters = ecs.query<const Counter>();
+        counters.each([&valid](flecs::entity, Counter const &c) {
+            valid = valid && c.value == warmup + frames;
+        });
+
+        std::printf("threads: %2d, frame: %8.1f us%s\n", threads, us,
+                valid ? "" : ", counter mismatch");
+        if (!valid) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <rise/util/jobs.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    template<typename F>
+    double bestOf(int runs, F &&f) {
+        double best = 1e30;
+        for (int run = 0; run != runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+}
+
+// пропускная способность пула: parallelFor против потока на задачу и одного потока,
+// поток мелких задач, вложенный parallelFor и фоновые задачи во время parallelFor.
+// Аргумент - число рабочих потоков, по умолчанию по ядру на поток, кроме главного
+int main(int argc, char **argv) {
+    unsigned workers = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1]))
+            : std::max(1u, std::thread::hardware_concurrency()) - 1;
+    rise::JobSystem jobs(workers);
+    std::printf("workers %u\n", jobs.workerCount());
+
+    constexpr size_t count = 1 << 22;
+    constexpr size_t grain = count / 64;
+    std::vector<float> input(count, 1.0f), output(count);
+    auto body = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i != end; ++i) {
+            output[i] = std::sqrt(input[i] * static_cast<float>(i) + 1.0f);
+        }
+    };
+
+    double serial = bestOf(10, [&] { body(0, count); });
+    double pooled = bestOf(10, [&] { jobs.parallelFor(0, count, grain, body); });
+    double threads = bestOf(10, [&] {
+        std::vector<std::thread> tasks;
+        for (size_t first = 0; first < count; first += grain) {
+            tasks.emplace_back(body, first, std::min(count, first + grain));
+        }
+        for (auto &task : tasks) {
+            task.join();
+        }
+    });
+    std::printf("%zu elements in %zu tasks: serial %.0f us, jobs %.0f us, "
+                "thread per task %.0f us\n", count, count / grain, serial, pooled, threads);
+
+    constexpr int tiny = 200000;
+    std::atomic<int64_t> sum{0};
+    double tinyTime = bestOf(3, [&] {
+        rise::JobCounter counter;
+        for (int i = 0; i != tiny; ++i) {
+            jobs.run(counter, [&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); });
+        }
+        jobs.wait(counter);
+    });
+    bool tinyOk = sum.load() == 3 * (int64_t(tiny) - 1) * tiny / 2;
+    std::printf("%d tiny jobs: %.0f us, %.0f ns per job\n", tiny, tinyTime,
+            tinyTime * 1000 / tiny);
+
+    std::atomic<int> nested{0};
+    rise::JobCounter outer;
+    for (int i = 0; i != 64; ++i) {
+        jobs.run(outer, [&] {
+            jobs.parallelFor(0, 1000, 10, [&](size_t begin, size_t end) {
+                nested.fetch_add(static_cast<int>(end - begin));
+            });
+        });
+    }
+    jobs.wait(outer);
+
+    // фоновые задачи не должны попадать в wait главного потока
+    std::atomic<int> background{0};
+    rise::JobCounter loads;
+    for (int i = 0; i != 16; ++i) {
+        jobs.runBackground(loads, [&background] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            background.fetch_add(1);
+        });
+    }
+    double frame = bestOf(1, [&] { jobs.parallelFor(0, count, grain, body); });
+    jobs.waitBackground(loads);
+    std::printf("parallelFor next to 16 background loads of 5 ms: %.0f us\n", frame);
+
+    bool ok = tinyOk && nested.load() == 64 * 1000 && background.load() == 16;
+    std::printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
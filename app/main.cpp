@@ -6,6 +6,8 @@
 #include <rise/physics/module.hpp>
 #include <rise/editor/gui.hpp>
 #include <glm/gtx/rotate_vector.hpp>
+#include <thread>
+#include <algorithm>
 
 using namespace rise;
 
@@ -48,28 +50,17 @@ flecs::entity makeModelPreset(flecs::world &ecs, flecs::entity application, std:
             set<rendering::Path>({texturesFolder + "/albedo.png"}).
             add<rendering::Texture>();
 
-    auto panelRoughness = ecs.entity().
+    auto panelOrm = ecs.entity().
             set<rendering::RegTo>({application}).
-            set<rendering::Path>({texturesFolder + "/roughness.png"}).
-            add<rendering::Texture>();
-
-    auto panelAo = ecs.entity().
-            set<rendering::RegTo>({application}).
-            set<rendering::Path>({texturesFolder + "/ao.png"}).
-            add<rendering::Texture>();
-
-    auto panelMetallic = ecs.entity().
-            set<rendering::RegTo>({application}).
-            set<rendering::Path>({texturesFolder + "/metallic.png"}).
+            set<rendering::OrmPath>({texturesFolder + "/ao.png", texturesFolder + "/roughness.png",
+                    texturesFolder + "/metallic.png"}).
             add<rendering::Texture>();
 
     return ecs.entity(name.c_str()).
             set<rendering::RegTo>({application}).
             add_instanceof(mesh).
             set<rendering::AlbedoTexture>({panelAlbedo}).
-            set<rendering::RoughnessTexture>({panelRoughness}).
-            set<rendering::MetallicTexture>({panelMetallic}).
-            set<rendering::AoTexture>({panelAo}).
+            set<rendering::PackedOrmTexture>({panelOrm}).
             set<rendering::Scale3D>(scale).
             set<rendering::Albedo>(albedo).
             add<rendering::Material>();
@@ -117,12 +108,15 @@ int main() {
 
     auto windowSize = ecs.entity("WindowSize").set<rendering::Extent2D>({1920, 1080});
 
+    // один размер на рабочие потоки flecs и пул задач рендера
+    auto threads = std::max(2u, std::thread::hardware_concurrency());
     auto application = ecs.entity("Minecraft2").
             add_instanceof(windowSize).
+            set<rendering::Threads>({threads}).
             add<rendering::LLGLApplication>();
 
-    rendering::guiSubmodule<const rendering::RenderTo, rendering::Position3D, rendering::Rotation3D,
-            rendering::Scale3D>(ecs, "drawImGuizmo", application, editor::imGuizmoSubmodule);
+    rendering::guiSubmodule<const rendering::RenderTo, rendering::Position3D,
+            rendering::Orientation3D, rendering::Scale3D>(ecs, "drawImGuizmo", application, editor::imGuizmoSubmodule);
     rendering::guiSubmodule(ecs, "drawComponents", application, editor::guiSubmodule);
 
     auto camera = ecs.entity("Viewport").
@@ -250,5 +244,6 @@ int main() {
     }
 
     ecs.set_target_fps(60);
-    while (ecs.progress()) {}
+    ecs.set_threads(static_cast<int32_t>(threads));
+    while (rendering::progress(ecs)) {}
 }
@@ -0,0 +1,114 @@
+#include <rise/util/flecs_os.hpp>
+#include <flecs.h>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+struct Position {
+    float x, y, z;
+};
+
+struct Spin {
+    float speed;
+};
+
+namespace {
+    // поворот вокруг центра, как rotateBalls в app/main.cpp, с запасом работы на сущность
+    void spin(flecs::entity e, Spin const &spin, Position &p) {
+        float angle = e.delta_time() * spin.speed;
+        for (int i = 0; i != 8; ++i) {
+            float c = std::cos(angle);
+            float s = std::sin(angle);
+            float x = p.x * c - p.z * s;
+            p.z = p.x * s + p.z * c;
+            p.x = x;
+        }
+    }
+
+    double checksum(flecs::world &ecs) {
+        double sum = 0;
+        ecs.query<const Position>().each([&sum](flecs::entity, Position const &p) {
+            sum += p.x + p.z;
+        });
+        return sum;
+    }
+}
+
+// 50k сущностей: одна и та же счётная система как система главного потока (kind(0) и ecs_run,
+// как rendering::mainThreadSystem) и в конвейере flecs с 1, 2, 4 и всеми ядрами
+int main() {
+    const int entities = 50000;
+    const int warmup = 20;
+    const int frames = 200;
+
+    stdcpp_set_os_api();
+
+    std::vector<int32_t> threadCounts{0, 1, 2, 4};
+    auto hardware = static_cast<int32_t>(std::max(1u, std::thread::hardware_concurrency()));
+    if (std::find(threadCounts.begin(), threadCounts.end(), hardware) == threadCounts.end()) {
+        threadCounts.push_back(hardware);
+    }
+
+    double reference = 0;
+    double mainThread = 0;
+    std::printf("entities: %d\n", entities);
+    for (auto threads : threadCounts) {
+        flecs::world ecs;
+        ecs.component<Position>("Position");
+        ecs.component<Spin>("Spin");
+
+        // threads == 0 - система вне конвейера, запускаемая с главного потока
+        flecs::entity_t system = 0;
+        if (threads == 0) {
+            system = ecs.system<const Spin, Position>().kind(0).each(spin).id();
+        } else {
+            ecs.system<const Spin, Position>().each(spin);
+            ecs.set_threads(threads);
+        }
+
+        for (int i = 0; i != entities; ++i) {
+            ecs.entity().
+                    set<Position>({float(i % 100), 0, float(i / 100)}).
+                    set<Spin>({1.0f + float(i % 7)});
+        }
+
+        auto frame = [&] {
+            if (system) {
+                ecs_run(ecs.c_ptr(), system, 1.0f / 60, nullptr);
+            }
+            ecs.progress(1.0f / 60);
+        };
+        for (int i = 0; i != warmup; ++i) {
+            frame();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i != frames; ++i) {
+            frame();
+        }
+        double us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count() / frames;
+
+        // все варианты обязаны прийти к одним и тем же позициям
+        double sum = checksum(ecs);
+        if (threads == 0) {
+            reference = sum;
+            mainThread = us;
+        }
+        bool valid = std::abs(sum - reference) <= 1e-6 * std::abs(reference) + 1e-3;
+
+        if (threads == 0) {
+            std::printf("main thread: %8.1f us\n", us);
+        } else {
+            std::printf("threads: %2d, frame: %8.1f us, speedup: %4.2fx%s\n", threads, us,
+                    mainThread / us, valid ? "" : ", checksum mismatch");
+        }
+        if (!valid) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <rise/rendering/queue.hpp>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace rise::rendering;
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, char const *what) {
+        if (!condition) {
+            std::printf("FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    struct Packet {
+        uint32_t pipeline;
+        uint32_t heap;
+        uint32_t mesh;
+        uint32_t id;
+    };
+
+    // запоминает установленное состояние и проверяет, что каждый пакет рисуется с ним
+    struct Recorder {
+        uint32_t pipelineState = ~0u;
+        uint32_t heapState = ~0u;
+        uint32_t meshState = ~0u;
+        std::vector<uint32_t> drawn;
+        uint32_t draws = 0;
+        bool consistent = true;
+
+        void pipeline(uint32_t handle) {
+            pipelineState = handle;
+        }
+
+        void heap(uint32_t handle, Packet const &) {
+            heapState = handle;
+        }
+
+        void mesh(uint32_t handle, Packet const &) {
+            meshState = handle;
+        }
+
+        void draw(Packet const *packets, size_t count) {
+            ++draws;
+            for (size_t i = 0; i != count; ++i) {
+                consistent = consistent && packets[i].pipeline == pipelineState &&
+                        packets[i].heap == heapState && packets[i].mesh == meshState;
+                drawn.push_back(packets[i].id);
+            }
+        }
+    };
+
+    void sortsLikeStdSort() {
+        std::mt19937_64 random(7);
+        std::vector<SortItem> items(10000);
+        for (uint32_t i = 0; i != items.size(); ++i) {
+            // старшие байты часто совпадают, как у реальных ключей
+            items[i] = {random() & 0x0000FFFF00FF00FFull, i};
+        }
+
+        auto expected = items;
+        std::stable_sort(expected.begin(), expected.end(), [](auto const &a, auto const &b) {
+            return a.key < b.key;
+        });
+
+        std::vector<SortItem> scratch;
+        radixSort(items, scratch);
+
+        bool same = true;
+        for (size_t i = 0; i != items.size(); ++i) {
+            same = same && items[i].key == expected[i].key &&
+                    items[i].index == expected[i].index;
+        }
+        check(same, "radix sort is stable and matches std::stable_sort");
+    }
+
+    void handlesAreDense() {
+        HandleTable<std::string> table;
+        check(table.get("a") == 0, "first handle is 0");
+        check(table.get("b") == 1, "second handle is 1");
+        check(table.get("a") == 0, "same value keeps its handle");
+        check(table[1] == "b", "handle maps back to its value");
+        check(table.size() == 2, "table size");
+        table.clear();
+        check(table.get("b") == 0, "handles restart after clear");
+    }
+
+    void groupsByState() {
+        RenderQueue<Packet> queue;
+        uint32_t id = 0;
+        for (uint32_t pipeline = 0; pipeline != 2; ++pipeline) {
+            for (uint32_t mesh = 0; mesh != 3; ++mesh) {
+                for (uint16_t depth = 0; depth != 4; ++depth) {
+                    queue.push(pipeline, 5, mesh, depth, {pipeline, 5, mesh, id++});
+                }
+            }
+        }
+
+        RenderQueueStats stats;
+        Recorder recorder;
+        queue.sort();
+        queue.flush(recorder, stats);
+
+        check(recorder.consistent, "packets are drawn with their own state");
+        check(recorder.drawn.size() == id, "every packet is drawn once");
+        check(recorder.draws == 6, "one draw per pipeline and mesh");
+        check(stats.pipelineChanges == 2, "pipeline changes");
+        check(stats.meshChanges == 6, "mesh changes");
+        check(stats.keyOverflows == 0, "no key overflows");
+    }
+
+    // номера больше поля ключа: без полных номеров пакеты с heap и heap + 2^20
+    // слились бы в одну отрисовку с чужим набором дескрипторов
+    void overflowKeepsState() {
+        RenderQueue<Packet> queue;
+        const uint32_t big = sortKey::maxHeap + 1;
+        const uint32_t heaps[] = {3, big + 3, big * 2, 3, sortKey::maxHeap, big + 3};
+        const uint32_t pipelines[] = {1, 1, 300, 1, 1, 1};
+
+        for (uint32_t i = 0; i != 6; ++i) {
+            queue.push(pipelines[i], heaps[i], 0, uint16_t(i), {pipelines[i], heaps[i], 0, i});
+        }
+
+        RenderQueueStats stats;
+        Recorder recorder;
+        queue.sort();
+        queue.flush(recorder, stats);
+
+        check(recorder.consistent, "overflowed handles keep their state");
+        check(recorder.drawn.size() == 6, "overflowed packets are not dropped");
+        check(stats.keyOverflows == 3, "overflows are counted");
+
+        queue.clear();
+        RenderQueueStats cleared;
+        queue.flush(recorder, cleared);
+        check(cleared.keyOverflows == 0 && cleared.packets == 0, "clear resets the queue");
+    }
+}
+
+int main() {
+    sortsLikeStdSort();
+    handlesAreDense();
+    groupsByState();
+    overflowKeepsState();
+
+    if (failures) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("queue: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <rise/util/soa.hpp>
+#include <chrono>
+#include <cstdio>
+
+using namespace rise;
+
+namespace {
+    template<typename F>
+    double bestOf(int runs, F &&f) {
+        double best = 1e30;
+        for (int run = 0; run != runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    // сумма x * y тремя способами: итератор с кортежем ref_wrap на элемент, плотные
+    // колонки и for_each_chunk
+    template<typename Container>
+    void run(char const *name, Container &container) {
+        const int runs = 200;
+        float byIterator = 0, byColumn = 0, byChunk = 0;
+
+        double iteratorTime = bestOf(runs, [&] {
+            float sum = 0;
+            for (auto it = container.begin(); it != container.end(); ++it) {
+                auto row = *it;
+                sum += std::get<0>(row).get() * std::get<1>(row).get();
+            }
+            byIterator = sum;
+        });
+
+        double columnTime = bestOf(runs, [&] {
+            auto x = container.template column<0>();
+            auto y = container.template column<1>();
+            float sum = 0;
+            for (size_t i = 0; i != x.size(); ++i) {
+                sum += x[i] * y[i];
+            }
+            byColumn = sum;
+        });
+
+        double chunkTime = bestOf(runs, [&] {
+            float sum = 0;
+            container.for_each_chunk(4096, [&sum](Span<float> x, Span<float> y, Span<int>) {
+                float partial = 0;
+                for (size_t i = 0; i != x.size(); ++i) {
+                    partial += x[i] * y[i];
+                }
+                sum += partial;
+            });
+            byChunk = sum;
+        });
+
+        std::printf("%-12s iterator %8.1f us, column %8.1f us, chunks %8.1f us (%g %g %g)\n",
+                name, iteratorTime, columnTime, chunkTime, byIterator, byColumn, byChunk);
+    }
+}
+
+int main() {
+    const size_t count = 1 << 16;
+
+    SoaVector<float, float, int> vector;
+    SoaSlotMap<float, float, int> slotMap;
+    for (size_t i = 0; i != count; ++i) {
+        vector.push_back(std::tuple{float(i % 7), 0.5f, int(i)});
+        slotMap.push_back(std::tuple{float(i % 7), 0.5f, int(i)});
+    }
+
+    run("SoaVector", vector);
+    run("SoaSlotMap", slotMap);
+    return 0;
+}
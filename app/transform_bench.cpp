@@ -0,0 +1,77 @@
+#include <rise/rendering/llgl/transform.hpp>
+#include <rise/util/jobs.hpp>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cmath>
+
+using namespace rise::rendering;
+
+namespace {
+    template<typename F>
+    double bestOf(int runs, F &&f) {
+        double best = 1e30;
+        for (int run = 0; run != runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+}
+
+// построение матриц моделей: скалярный вариант, SIMD ядро в одном потоке и ядро,
+// разбитое на задачи пула, для 1k, 10k и 100k моделей
+int main() {
+    rise::JobSystem jobs;
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    std::printf("%8s %12s %12s %12s %10s\n", "models", "scalar us", "simd us", "jobs us",
+            "max error");
+    for (size_t count : {1000, 10000, 100000}) {
+        TransformBatch batch;
+        for (size_t i = 0; i != count; ++i) {
+            glm::quat rotation(value(random), value(random), value(random), value(random));
+            float length = std::sqrt(rotation.w * rotation.w + rotation.x * rotation.x +
+                    rotation.y * rotation.y + rotation.z * rotation.z);
+            rotation = glm::quat(rotation.w / length, rotation.x / length,
+                    rotation.y / length, rotation.z / length);
+            batch.push({value(random) * 100, value(random) * 100, value(random) * 100},
+                    rotation, {1 + value(random) * 0.5f, 1, 1 + value(random) * 0.5f});
+        }
+
+        std::vector<glm::mat4> reference(count), simd(count), parallel(count);
+        int runs = count < 100000 ? 200 : 20;
+
+        double scalarTime = bestOf(runs, [&] {
+            composeTransformsScalar(batch, 0, count, reference.data());
+        });
+        double simdTime = bestOf(runs, [&] {
+            composeTransforms(batch, 0, count, simd.data());
+        });
+        double jobsTime = bestOf(runs, [&] {
+            jobs.parallelFor(0, count, transformGrain, [&](size_t begin, size_t end) {
+                composeTransforms(batch, begin, end, parallel.data());
+            });
+        });
+
+        float error = 0;
+        for (size_t i = 0; i != count; ++i) {
+            for (int c = 0; c != 4; ++c) {
+                for (int r = 0; r != 4; ++r) {
+                    error = std::max(error, std::abs(simd[i][c][r] - reference[i][c][r]));
+                    error = std::max(error, std::abs(parallel[i][c][r] - reference[i][c][r]));
+                }
+            }
+        }
+
+        std::printf("%8zu %12.1f %12.1f %12.1f %10.2e\n", count, scalarTime, simdTime,
+                jobsTime, error);
+        if (error > 1e-3f) {
+            return 1;
+        }
+    }
+    return 0;
+}
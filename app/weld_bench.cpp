@@ -0,0 +1,52 @@
+#include <rise/rendering/llgl/geometry.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+using namespace rise::rendering;
+using scenePipeline::Vertex;
+
+// два треугольника квада в порядке обхода углов
+const std::pair<int, int> quad[] = {{0, 0}, {1, 0}, {0, 1}, {1, 0}, {1, 1}, {0, 1}};
+
+// сварка около миллиона треугольников из сетки, разобранной на отдельные треугольники,
+// как её отдаёт tinyobjloader
+int main() {
+    const int n = 708;
+    const int runs = 5;
+
+    std::vector<Vertex> soup;
+    soup.reserve(size_t(n) * n * 6);
+    auto corner = [n](int x, int y) {
+        Vertex vertex{};
+        vertex.pos = {x * 0.1f, std::sin(x * 0.05f) * std::cos(y * 0.05f), y * 0.1f};
+        vertex.normal = {0.0f, 1.0f, 0.0f};
+        vertex.texCoord = {x / float(n), y / float(n)};
+        return vertex;
+    };
+    for (int y = 0; y != n; ++y) {
+        for (int x = 0; x != n; ++x) {
+            for (auto[dx, dy] : quad) {
+                soup.push_back(corner(x + dx, y + dy));
+            }
+        }
+    }
+
+    double best = 1e30;
+    size_t vertices = 0;
+    for (int run = 0; run != runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        VertexWelder welder(soup.size());
+        for (auto const &vertex : soup) {
+            welder.add(vertex);
+        }
+        best = std::min(best, std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+        vertices = welder.vertices.size();
+    }
+
+    std::printf("triangles: %zu, welded vertices: %zu\n", soup.size() / 3, vertices);
+    std::printf("weld: %.1f ms, %.2f ns/index\n", best, best * 1e6 / soup.size());
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <rise/rendering/llgl/geometry.hpp>
+#include <cstdio>
+#include <cmath>
+
+using namespace rise::rendering;
+using scenePipeline::Vertex;
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, char const *what) {
+        if (!condition) {
+            std::printf("FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+
+    bool same(glm::vec3 a, glm::vec3 b) {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    bool same(glm::vec2 a, glm::vec2 b) {
+        return a.x == b.x && a.y == b.y;
+    }
+
+    // два треугольника квада в порядке обхода углов
+    const std::pair<int, int> quad[] = {{0, 0}, {1, 0}, {0, 1}, {1, 0}, {1, 1}, {0, 1}};
+
+    Vertex gridVertex(int x, int y, int n) {
+        Vertex vertex{};
+        vertex.pos = {x * 0.1f, y * 0.1f, 0.0f};
+        vertex.normal = {0.0f, 0.0f, 1.0f};
+        vertex.texCoord = {x / float(n), y / float(n)};
+        return vertex;
+    }
+
+    // сетка n x n из несвязанных треугольников: после сварки у соседних квадов общие углы
+    void weldGrid() {
+        const int n = 64;
+        std::vector<Vertex> soup;
+        for (int y = 0; y != n; ++y) {
+            for (int x = 0; x != n; ++x) {
+                for (auto[dx, dy] : quad) {
+                    soup.push_back(gridVertex(x + dx, y + dy, n));
+                }
+            }
+        }
+
+        VertexWelder welder(soup.size());
+        for (auto const &vertex : soup) {
+            welder.add(vertex);
+        }
+
+        check(welder.vertices.size() == size_t((n + 1) * (n + 1)), "grid vertex count");
+        check(welder.indices.size() == soup.size(), "grid index count");
+
+        bool topology = true;
+        for (size_t i = 0; i != soup.size(); ++i) {
+            auto const &welded = welder.vertices[welder.indices[i]];
+            topology = topology && same(welded.pos, soup[i].pos) &&
+                    same(welded.normal, soup[i].normal) &&
+                    same(welded.texCoord, soup[i].texCoord);
+        }
+        check(topology, "grid triangles keep their corners");
+
+        bool degenerate = false;
+        for (size_t i = 0; i != welder.indices.size(); i += 3) {
+            auto a = welder.indices[i], b = welder.indices[i + 1], c = welder.indices[i + 2];
+            degenerate = degenerate || a == b || b == c || a == c;
+        }
+        check(!degenerate, "no degenerate triangles");
+    }
+
+    // на рёбрах куба позиции совпадают, но нормали разные: шов должен сохраниться
+    void keepSeams() {
+        const glm::vec3 normals[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0},
+                {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+        VertexWelder welder(36);
+        for (auto normal : normals) {
+            glm::vec3 u = normal.x != 0 ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0);
+            glm::vec3 v = glm::cross(normal, u);
+            glm::vec3 corners[] = {normal - u - v, normal + u - v, normal + u + v,
+                    normal - u + v};
+            for (int i : {0, 1, 2, 0, 2, 3}) {
+                Vertex vertex{};
+                vertex.pos = corners[i];
+                vertex.normal = normal;
+                welder.add(vertex);
+            }
+        }
+
+        check(welder.vertices.size() == 24, "cube keeps 4 vertices per face");
+        check(welder.indices.size() == 36, "cube index count");
+    }
+
+    void weldSignedZero() {
+        Vertex positive{};
+        Vertex negative{};
+        negative.pos.x = -0.0f;
+        negative.texCoord.y = -0.0f;
+
+        VertexWelder welder(2);
+        welder.add(positive);
+        welder.add(negative);
+        check(welder.vertices.size() == 1, "-0 and 0 weld");
+    }
+
+    // разница в младших битах мантиссы - погрешность текстового формата
+    void weldRounding() {
+        Vertex a{};
+        a.pos = {0.3f, 1.7f, -2.1f};
+        Vertex b = a;
+        b.pos.x = std::nextafter(a.pos.x, 1.0f);
+        Vertex c = a;
+        c.pos.x = 0.3001f;
+
+        VertexWelder welder(3);
+        auto ia = welder.add(a);
+        auto ib = welder.add(b);
+        auto ic = welder.add(c);
+        check(ia == ib, "last-bit difference welds");
+        check(ia != ic, "distinct positions stay apart");
+    }
+}
+
+int main() {
+    weldGrid();
+    keepSeams();
+    weldSignedZero();
+    weldRounding();
+
+    if (failures) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("weld: all checks passed\n");
+    return 0;
+}
@@ -35,17 +35,12 @@ layout(binding = 1) uniform Material {
     float ao;
 } material;
 
-layout(binding = 2) uniform Model {
-    mat4 transform;
-} model;
-
 layout(binding = 3) uniform sampler modelSampler;
 layout(binding = 4) uniform texture2D albedoTexture;
-layout(binding = 5) uniform texture2D metallicTexture;
-layout(binding = 6) uniform texture2D roughnessTexture;
-layout(binding = 7) uniform texture2D aoTexture;
-layout(binding = 8) uniform textureCubeArray depthMap;
-layout(binding = 9) uniform sampler shadowSampler;
+// r - ambient occlusion, g - roughness, b - metallic
+layout(binding = 5) uniform texture2D ormTexture;
+layout(binding = 6) uniform textureCubeArray depthMap;
+layout(binding = 7) uniform sampler shadowSampler;
 
 const float constantFactor = 1.0f;
 const float linearFactor = 4.5;
@@ -138,13 +133,11 @@ float shadowCalculation(vec3 fragPos, int lightId) {
 void main()
 {
     vec3 albedoTex = texture(sampler2D(albedoTexture, modelSampler), texCoord).xyz;
-    float metallicTex = texture(sampler2D(metallicTexture, modelSampler), texCoord).x;
-    float roughnessTex = texture(sampler2D(roughnessTexture, modelSampler), texCoord).x;
-    float aoTex = texture(sampler2D(aoTexture, modelSampler), texCoord).x;
+    vec3 ormTex = texture(sampler2D(ormTexture, modelSampler), texCoord).xyz;
     vec3 albedo = albedoTex * material.albedo * inColor;
-    float metallic = metallicTex * material.metallic;
-    float roughness = roughnessTex * material.roughness;
-    float ao = aoTex * material.ao;
+    float metallic = ormTex.b * material.metallic;
+    float roughness = ormTex.g * material.roughness;
+    float ao = ormTex.r * material.ao;
 
     vec3 norm = normalize(inNormal);
     vec3 resultColor = vec3(0.0, 0.0, 0.0);
@@ -2,10 +2,13 @@
 
 // Vertex input
 layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 color;
+layout(location = 1) in vec2 normal; // октаэдрическая проекция
+layout(location = 2) in vec4 color;
 layout(location = 3) in vec2 texCoord;
 
+// Instance input
+layout(location = 4) in mat4 transform;
+
 // Vertex output
 layout(location = 0) out vec3 outPosition;
 layout(location = 1) out vec3 outNormal;
@@ -35,20 +38,25 @@ layout(binding = 1) uniform Material {
 	vec4 diffuseColor;
 } material;
 
-layout(binding = 2) uniform Model {
-	mat4 transform;
-} model;
-
 out gl_PerVertex
 {
 	vec4 gl_Position;
 };
 
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0) {
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0 ? 1.0 : -1.0, v.y >= 0 ? 1.0 : -1.0);
+	}
+	return normalize(v);
+}
+
 void main()
 {
-	gl_Position = viewport.projection * viewport.view * model.transform * vec4(position, 1);
-	outPosition = vec3(model.transform * vec4(position, 1.0));
-	outNormal = mat3(transpose(inverse(model.transform))) * normal;
-	outColor = color;
+	gl_Position = viewport.projection * viewport.view * transform * vec4(position, 1);
+	outPosition = vec3(transform * vec4(position, 1.0));
+	outNormal = mat3(transpose(inverse(transform))) * decodeOctahedral(normal);
+	outColor = color.rgb;
 	outTexCoord = texCoord;
 }
@@ -3,10 +3,9 @@
 // Vertex input
 layout(location = 0) in vec3 inPosition;
 
-layout(binding = 0) uniform Model {
-    mat4 transform;
-} model;
+// Instance input
+layout(location = 1) in mat4 transform;
 
 void main() {
-    gl_Position = model.transform * vec4(inPosition, 1.0);
+    gl_Position = transform * vec4(inPosition, 1.0);
 }
@@ -160,7 +160,7 @@ namespace rise::editor {
     }
 
     void imGuizmoSubmodule(flecs::entity e, rendering::RegTo app, rendering::RenderTo viewport,
-            rendering::Position3D position, rendering::Rotation3D rotation,
+            rendering::Position3D position, rendering::Orientation3D orientation,
             rendering::Scale3D scale) {
 
         ImGuizmo::OPERATION *currentImGuizmoOp = nullptr;
@@ -198,9 +198,9 @@ namespace rise::editor {
         ImGuiIO &io = ImGui::GetIO();
         ImGuizmo::SetRect(0, 0, io.DisplaySize.x, io.DisplaySize.y);
 
-        glm::mat4 modelMatrix;
-        ImGuizmo::RecomposeMatrixFromComponents(&position.x, &rotation.x, &scale.x,
-                &modelMatrix[0][0]);
+        glm::mat4 modelMatrix = glm::translate(glm::mat4(1), toGlm(position)) *
+                glm::mat4_cast(toGlm(orientation));
+        modelMatrix = glm::scale(modelMatrix, toGlm(scale));
 
         auto vPosition = *viewport.e.get<rendering::Position3D>();
         auto vRotation = *viewport.e.get<rendering::Rotation3D>();
@@ -211,13 +211,28 @@ namespace rise::editor {
 
         if (ImGuizmo::Manipulate(&view[0][0], &projection[0][0], *currentImGuizmoOp,
                 ImGuizmo::WORLD, &modelMatrix[0][0], nullptr, nullptr)) {
-            ImGuizmo::DecomposeMatrixToComponents(&modelMatrix[0][0], &position.x,
-                    &rotation.x, &scale.x);
+            glm::vec3 axes[3];
+            glm::vec3 scaleVec;
+            for (int i = 0; i != 3; ++i) {
+                scaleVec[i] = glm::length(glm::vec3(modelMatrix[i]));
+                axes[i] = glm::vec3(modelMatrix[i]) / scaleVec[i];
+            }
+
+            position = rendering::fromGlmPosition3D(glm::vec3(modelMatrix[3]));
+            orientation = rendering::fromGlmOrientation3D(glm::normalize(
+                    glm::quat_cast(glm::mat3(axes[0], axes[1], axes[2]))));
+            scale = rendering::fromGlmScale3D(scaleVec);
+
+            e.set<rendering::Position3D>(position);
+            e.set<rendering::Orientation3D>(orientation);
+            e.set<rendering::Scale3D>(scale);
         }
 
-        e.set<rendering::Position3D>(position);
-        e.set<rendering::Rotation3D>(rotation);
-        e.set<rendering::Scale3D>(scale);
+        // углы для панели компонентов пересчитываются только у выбранной сущности и без
+        // OnSet, чтобы не переводить их обратно в Orientation3D
+        if (e.has<rendering::Rotation3D>()) {
+            *e.get_mut<rendering::Rotation3D>() = rendering::quatToRotation(toGlm(orientation));
+        }
     }
 
     Module::Module(flecs::world &ecs) {
@@ -232,8 +247,8 @@ namespace rise::editor {
                 each([](flecs::entity e) {
             e.set<GuiId>({new GuiState{ImGuizmo::TRANSLATE, flecs::entity(0)}});
         });
-        ecs.system<rendering::RegTo>("tryPick", "rise.rendering.Viewport").kind(
-                flecs::OnStore).each(tryPick);
+        rendering::mainThreadSystem(ecs, flecs::OnStore,
+                ecs.system<rendering::RegTo>("tryPick", "rise.rendering.Viewport"), tryPick);
     }
 
     void guiSubmodule(flecs::entity e, rendering::RegTo app) {
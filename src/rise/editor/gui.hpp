@@ -51,7 +51,7 @@ namespace rise::editor {
     void guiSubmodule(flecs::entity e, rendering::RegTo state);
 
     void imGuizmoSubmodule(flecs::entity e, rendering::RegTo app, rendering::RenderTo viewport,
-            rendering::Position3D position, rendering::Rotation3D rotation,
+            rendering::Position3D position, rendering::Orientation3D orientation,
             rendering::Scale3D scale);
 
     template<typename T>
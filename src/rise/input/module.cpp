@@ -85,13 +85,14 @@ namespace rise::input {
         ecs.import<rendering::Module>();
         ecs.component<Controllable>("Controllable");
 
-        ecs.system<Position3D, const Rotation3D>("processKeyboard", "Controllable").
-                kind(flecs::PostLoad).each(processKeyboard);
+        mainThreadSystem(ecs, flecs::PostLoad,
+                ecs.system<Position3D, const Rotation3D>("processKeyboard", "Controllable"),
+                processKeyboard);
 
-        ecs.system<>("processRelative", "OWNED:rise.rendering.Relative").
-                kind(flecs::OnLoad).each(processRelative);
+        mainThreadSystem(ecs, flecs::OnLoad,
+                ecs.system<>("processRelative", "OWNED:rise.rendering.Relative"), processRelative);
 
-        ecs.system<const RegTo, Rotation3D>("processMouse", "Controllable").
-                kind(flecs::PostLoad).each(processMouse);
+        mainThreadSystem(ecs, flecs::PostLoad,
+                ecs.system<const RegTo, Rotation3D>("processMouse", "Controllable"), processMouse);
     }
 }
@@ -1,9 +1,11 @@
 #include <glm/gtx/euler_angles.hpp>
 #include "module.hpp"
+#include "rise/util/jobs.hpp"
 
 namespace rise::physics {
     using namespace std::chrono_literals;
     const uint32_t timeStep = 17; // ms
+    const size_t readbackGrain = 1024;
 
     struct PhysicBodyId {
         rp::RigidBody *id;
@@ -21,22 +23,8 @@ namespace rise::physics {
         return rp::Vector3(v.x, v.y, v.z);
     }
 
-    rp::Transform getTransform(rendering::Position3D pos, rendering::Rotation3D rot) {
-        rp::Vector3 vector(convert(toGlm(pos)));
-
-        float angle = std::max({rot.x, rot.y, rot.z});
-        rp::Quaternion qt;
-        if (angle != 0) {
-            auto q = glm::angleAxis(glm::radians(angle), glm::normalize(toGlm(rot)));
-            qt.x = q.x;
-            qt.y = q.y;
-            qt.z = q.z;
-            qt.w = q.w;
-        } else {
-            qt = rp::Quaternion::fromEulerAngles({0, 0, 0});
-        }
-
-        return {vector, qt};
+    rp::Transform getTransform(rendering::Position3D pos, rendering::Orientation3D rot) {
+        return {convert(toGlm(pos)), rp::Quaternion(rot.x, rot.y, rot.z, rot.w)};
     }
 
     void updateRigidBody(flecs::entity e, rendering::RegTo app, PhysicBody body) {
@@ -47,8 +35,8 @@ namespace rise::physics {
             rendering::Position3D pos{0, 0, 0};
             if (auto pPos = e.get<rendering::Position3D>()) pos = *pPos;
 
-            rendering::Rotation3D rot{0, 0, 0};
-            if (auto pRot = e.get<rendering::Rotation3D>()) rot = *pRot;
+            rendering::Orientation3D rot{0, 0, 0, 1};
+            if (auto pRot = e.get<rendering::Orientation3D>()) rot = *pRot;
 
             auto rpBody = state->id->world->createRigidBody(getTransform(pos, rot));
             rpBody->setLinearDamping(0.1);
@@ -59,17 +47,49 @@ namespace rise::physics {
         }
     }
 
-    void updateRigidBodyTransform(flecs::entity, PhysicBodyId body, rendering::Position3D pos,
-            rendering::Rotation3D rot) {
-        body.id->setTransform(getTransform(pos, rot));
+    void pushBodyUpdate(rendering::RegTo app, BodyUpdate update) {
+        auto &state = *app.e.get<PhysicsId>()->id;
+        std::lock_guard lock(state.updatesMutex);
+        state.updates.push_back(update);
     }
 
-    void updateVelocity(flecs::entity, PhysicBodyId body, Velocity velocity) {
-        body.id->setLinearVelocity({velocity.x, velocity.y, velocity.z});
+    void updateRigidBodyTransform(flecs::entity, rendering::RegTo app, PhysicBodyId body,
+            rendering::Position3D pos, rendering::Orientation3D rot) {
+        BodyUpdate update{BodyUpdate::eTransform, body.id};
+        update.transform = getTransform(pos, rot);
+        pushBodyUpdate(app, update);
     }
 
-    void updateMass(flecs::entity, PhysicBodyId body, Mass mass) {
-        body.id->setMass(mass.kg);
+    void updateVelocity(flecs::entity, rendering::RegTo app, PhysicBodyId body,
+            Velocity velocity) {
+        BodyUpdate update{BodyUpdate::eVelocity, body.id};
+        update.velocity = {velocity.x, velocity.y, velocity.z};
+        pushBodyUpdate(app, update);
+    }
+
+    void updateMass(flecs::entity, rendering::RegTo app, PhysicBodyId body, Mass mass) {
+        BodyUpdate update{BodyUpdate::eMass, body.id};
+        update.mass = mass.kg;
+        pushBodyUpdate(app, update);
+    }
+
+    // в порядке постановки: более позднее изменение того же тела перекрывает раннее
+    void applyBodyUpdates(PhysicsState &state) {
+        std::lock_guard lock(state.updatesMutex);
+        for (auto const &update : state.updates) {
+            switch (update.kind) {
+                case BodyUpdate::eTransform:
+                    update.body->setTransform(update.transform);
+                    break;
+                case BodyUpdate::eVelocity:
+                    update.body->setLinearVelocity(update.velocity);
+                    break;
+                case BodyUpdate::eMass:
+                    update.body->setMass(update.mass);
+                    break;
+            }
+        }
+        state.updates.clear();
     }
 
     void updateBoxCollision(flecs::entity e, rendering::RegTo app, PhysicBodyId body,
@@ -100,6 +120,8 @@ namespace rise::physics {
 
     void updatePhysicsTime(flecs::entity e, PhysicsId id) {
         auto &state = *id.id;
+        applyBodyUpdates(state);
+
         state.accumulator += static_cast<uint32_t>(e.delta_time() * 1000);
         state.accumulator = std::min(500u, state.accumulator);
 
@@ -109,19 +131,35 @@ namespace rise::physics {
         }
     }
 
-    void updatePhysic(flecs::entity e, PhysicBodyId body) {
-        auto const &transform = body.id->getTransform();
-        auto position = transform.getPosition();
+    // преобразования тел копируются задачами пула, каждая в свой отрезок readback, а set
+    // с его OnSet системами остаётся в главном потоке
+    void updatePhysics(flecs::entity e, PhysicsId id) {
+        auto &state = *id.id;
+        auto world = state.world;
+        size_t count = world->getNbRigidBodies();
+        state.readback.resize(count);
+
+        auto read = [&state, world](size_t begin, size_t end) {
+            for (size_t i = begin; i != end; ++i) {
+                auto body = world->getRigidBody(static_cast<uint32_t>(i));
+                state.readback[i] = {static_cast<flecs::entity *>(body->getUserData()),
+                        body->getTransform()};
+            }
+        };
+        if (auto jobs = e.get<rendering::JobSystemId>()) {
+            jobs->id->parallelFor(0, count, readbackGrain, read);
+        } else {
+            read(0, count);
+        }
 
-        float angle;
-        rp::Vector3 rotation;
-        transform.getOrientation().getRotationAngleAxis(angle, rotation);
+        for (auto const &[entity, transform] : state.readback) {
+            auto position = transform.getPosition();
+            auto orientation = transform.getOrientation();
 
-        e.set<rendering::Position3D>({position.x, position.y, position.z});
-        e.set<rendering::Rotation3D>({
-                glm::degrees(rotation.x * angle),
-                glm::degrees(rotation.y * angle),
-                glm::degrees(rotation.z * angle)});
+            entity->set<rendering::Position3D>({position.x, position.y, position.z});
+            entity->set<rendering::Orientation3D>({orientation.x, orientation.y, orientation.z,
+                    orientation.w});
+        }
     }
 
     void initPhysicState(flecs::entity e) {
@@ -152,8 +190,9 @@ namespace rise::physics {
         ecs.system<const rendering::RegTo, const PhysicBody>("updateRigidBody").
                 kind(flecs::OnSet).each(updateRigidBody);
 
-        ecs.system<const PhysicBodyId, const rendering::Position3D, const rendering::Rotation3D>(
-                "updateRigidBodyTransform").kind(flecs::OnSet).each(updateRigidBodyTransform);
+        ecs.system<const rendering::RegTo, const PhysicBodyId, const rendering::Position3D,
+                const rendering::Orientation3D>("updateRigidBodyTransform").kind(flecs::OnSet).
+                each(updateRigidBodyTransform);
 
         ecs.system<const rendering::RegTo, const PhysicBodyId, const BoxCollision>(
                 "updateBoxCollision").kind(flecs::OnSet).each(updateBoxCollision);
@@ -161,15 +200,17 @@ namespace rise::physics {
         ecs.system<const rendering::RegTo, const PhysicBodyId, const SphereCollision>(
                 "updateSphereCollision").kind(flecs::OnSet).each(updateSphereCollision);
 
-        ecs.system<const PhysicBodyId, const Velocity>(
+        ecs.system<const rendering::RegTo, const PhysicBodyId, const Velocity>(
                 "updateVelocity").kind(flecs::OnSet).each(updateVelocity);
 
-        ecs.system<const PhysicBodyId, const Mass>(
+        ecs.system<const rendering::RegTo, const PhysicBodyId, const Mass>(
                 "updateMass").kind(flecs::OnSet).each(updateMass);
 
-        ecs.system<const PhysicsId>().each(updatePhysicsTime).
-                each(updatePhysicsTime);
+        // reactphysics не потокобезопасен - шаг мира и чтение тел остаются в главном потоке
+        rendering::mainThreadSystem(ecs, flecs::PostLoad,
+                ecs.system<const PhysicsId>("updatePhysicsTime"), updatePhysicsTime);
 
-        ecs.system<PhysicBodyId>("updatePhysics", "[in] OWNED:PhysicBody").each(updatePhysic);
+        rendering::mainThreadSystem(ecs, flecs::PostLoad,
+                ecs.system<const PhysicsId>("updatePhysics"), updatePhysics);
     }
 }
\ No newline at end of file
@@ -2,14 +2,37 @@
 #include "rise/rendering/glm.hpp"
 #include "rise/rendering/module.hpp"
 #include <reactphysics3d/reactphysics3d.h>
+#include <vector>
+#include <mutex>
 
 namespace rise::physics {
     namespace rp = reactphysics3d;
 
+    // изменение тела из OnSet системы
+    struct BodyUpdate {
+        enum Kind {
+            eTransform,
+            eVelocity,
+            eMass,
+        };
+
+        Kind kind;
+        rp::RigidBody *body;
+        rp::Transform transform;
+        rp::Vector3 velocity;
+        float mass = 0;
+    };
+
     struct PhysicsState {
         rp::PhysicsCommon common;
         rp::PhysicsWorld *world = nullptr;
         uint32_t accumulator = 0; // ms
+        // преобразования тел после шага мира вместе с их сущностями
+        std::vector<std::pair<flecs::entity *, rp::Transform>> readback;
+        // OnSet системы вызываются и с рабочих потоков flecs, а reactphysics не потокобезопасен:
+        // изменения тел копятся здесь и применяются в главном потоке перед шагом мира
+        std::mutex updatesMutex;
+        std::vector<BodyUpdate> updates;
     };
 
     struct PhysicsId {
@@ -1,6 +1,8 @@
 #pragma once
 #include "module.hpp"
+#include <algorithm>
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 namespace rise::rendering {
     inline glm::vec2 toGlm(Extent2D val) {
@@ -35,6 +37,10 @@ namespace rise::rendering {
         return {val.r, val.g, val.b};
     }
 
+    inline glm::quat toGlm(Orientation3D val) {
+        return {val.w, val.x, val.y, val.z};
+    }
+
     inline glm::vec3 toGlm(Scale3D val) {
         return {val.x, val.y, val.z};
     }
@@ -67,6 +73,37 @@ namespace rise::rendering {
         return {val.x, val.y, val.z};
     }
 
+    inline Orientation3D fromGlmOrientation3D(glm::quat val) {
+        return {val.x, val.y, val.z, val.w};
+    }
+
+    // Rotation3D: угол в градусах - наибольшая компонента, ось - направление вектора
+    inline glm::quat rotationToQuat(Rotation3D val) {
+        float angle = std::max({val.x, val.y, val.z});
+        if (angle == 0) {
+            return {1, 0, 0, 0};
+        }
+        return glm::angleAxis(glm::radians(angle), glm::normalize(toGlm(val)));
+    }
+
+    // обратное преобразование: из пар (ось, угол) и (-ось, 360 - угол) выбирается та, у
+    // которой наибольшая компонента оси положительна и дальше от нуля
+    inline Rotation3D quatToRotation(glm::quat val) {
+        float angle = glm::degrees(glm::angle(val));
+        if (angle == 0) {
+            return {0, 0, 0};
+        }
+        glm::vec3 axis = glm::axis(val);
+        float top = std::max({axis.x, axis.y, axis.z});
+        float bottom = std::max({-axis.x, -axis.y, -axis.z});
+        if (bottom > top) {
+            axis = -axis;
+            angle = 360.0f - angle;
+            top = bottom;
+        }
+        return fromGlmRotation3D(axis * (angle / top));
+    }
+
     inline Scale3D fromGlmScale3D(glm::vec3 val) {
         return {val.x, val.y, val.z};
     }
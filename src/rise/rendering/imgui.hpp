@@ -13,7 +13,7 @@ namespace rise::rendering {
     void guiSubmodule(flecs::world &ecs, std::string const &name, flecs::entity app, F &&f,
             std::string const &query = {}) {
         auto expr = app.name().c_str() + std::string(":rise.rendering.GuiContext,") + query;
-        ecs.system<rendering::RegTo, Types...>(name.c_str(), expr.c_str()).
-                kind(flecs::PreStore).each(f);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<rendering::RegTo, Types...>(name.c_str(), expr.c_str()), f);
     }
 }
\ No newline at end of file
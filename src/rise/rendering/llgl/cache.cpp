@@ -0,0 +1,363 @@
+#include "cache.hpp"
+#include "geometry.hpp"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RISE_MESH_CACHE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace rise::rendering {
+    const uint32_t meshCacheVersion = 5;
+    const char meshCacheMagic[4] = {'R', 'M', 'S', 'H'};
+    const uint32_t textureCacheVersion = 2;
+    const char textureCacheMagic[4] = {'R', 'T', 'E', 'X'};
+
+    bool stampSource(std::string const &source, SourceStamp &stamp) {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(source, ec);
+        if (ec) {
+            return false;
+        }
+
+        auto size = std::filesystem::file_size(source, ec);
+        if (ec) {
+            return false;
+        }
+
+        stamp.time = static_cast<uint64_t>(time.time_since_epoch().count());
+        stamp.size = static_cast<uint64_t>(size);
+        return true;
+    }
+
+    uint64_t hashBytes(void const *data, size_t size, uint64_t hash) {
+        auto bytes = static_cast<unsigned char const *>(data);
+        for (size_t i = 0; i != size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t hashSource(std::string const &source) {
+        std::ifstream file(source, std::ios::binary);
+        uint64_t hash = fnvOffset;
+        char chunk[64 * 1024];
+
+        while (file) {
+            file.read(chunk, sizeof(chunk));
+            hash = hashBytes(chunk, static_cast<size_t>(file.gcount()), hash);
+        }
+        return hash;
+    }
+
+    std::string normalizePath(std::string const &path) {
+        std::error_code ec;
+        auto absolute = std::filesystem::absolute(path, ec);
+        return (ec ? std::filesystem::path(path) : absolute).lexically_normal().string();
+    }
+
+    bool stampSources(std::vector<std::string> const &sources, SourceStamp &stamp) {
+        stamp = {};
+        for (auto const &source : sources) {
+            SourceStamp one;
+            if (!stampSource(source, one)) {
+                return false;
+            }
+            stamp.time = stamp.time * 31 + one.time;
+            stamp.size += one.size;
+        }
+        return true;
+    }
+
+    uint64_t hashSources(std::vector<std::string> const &sources) {
+        uint64_t hash = 0;
+        for (auto const &source : sources) {
+            hash = hash * 1099511628211ull ^ hashSource(source);
+        }
+        return hash;
+    }
+
+    // источник сохранён заново без изменений (совпал хэш): новое время изменения пишется
+    // в заголовок кэша, чтобы следующие запуски не хэшировали источник повторно
+    void restampCache(std::string const &path, size_t offset, uint64_t time) {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (file) {
+            file.seekp(static_cast<std::streamoff>(offset));
+            file.write(reinterpret_cast<char const *>(&time), sizeof(time));
+        }
+    }
+
+    // у каждой записи своё временное имя: кэши текстур пишут фоновые задачи, и две загрузки
+    // с общим файлом кэша не должны писать в один и тот же временный файл
+    std::string tempCachePath(std::string const &path) {
+        static std::atomic<uint64_t> counter{0};
+        uint64_t process = 0;
+#ifdef RISE_MESH_CACHE_MMAP
+        process = static_cast<uint64_t>(getpid());
+#endif
+        auto thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return path + "." + std::to_string(process) + "." + std::to_string(thread) + "." +
+                std::to_string(counter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+    }
+
+    // при неудачной записи или переименовании временный файл не остаётся рядом с кэшем
+    bool replaceCache(std::string const &tmp, std::string const &path, bool written) {
+        std::error_code ec;
+        if (written) {
+            std::filesystem::rename(tmp, path, ec);
+        }
+        if (!written || ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    MeshCache::~MeshCache() {
+        close();
+    }
+
+    void MeshCache::close() {
+        if (!mData) {
+            return;
+        }
+
+#ifdef RISE_MESH_CACHE_MMAP
+        if (mMapped) {
+            munmap(mData, mSize);
+        } else {
+            delete[] static_cast<char *>(mData);
+        }
+#else
+        delete[] static_cast<char *>(mData);
+#endif
+        mData = nullptr;
+        mSize = 0;
+        mMapped = false;
+    }
+
+    bool MeshCache::open(std::string const &path, std::string const &source, uint32_t flags) {
+        close();
+
+        SourceStamp stamp;
+        if (!stampSource(source, stamp)) {
+            return false;
+        }
+
+#ifdef RISE_MESH_CACHE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info{};
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            mSize = static_cast<size_t>(info.st_size);
+            void *pData = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pData != MAP_FAILED) {
+                mData = pData;
+                mMapped = true;
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (file) {
+            mSize = static_cast<size_t>(file.tellg());
+            mData = new char[mSize];
+            file.seekg(0);
+            file.read(static_cast<char *>(mData), static_cast<std::streamsize>(mSize));
+        }
+#endif
+
+        if (!mData || mSize < sizeof(MeshCacheHeader)) {
+            close();
+            return false;
+        }
+
+        auto const &h = header();
+        size_t vertexSize = sizeof(glm::vec3) + sizeof(scenePipeline::PackedVertex);
+        size_t expected = sizeof(MeshCacheHeader) + size_t(h.numVertices) * vertexSize +
+                size_t(h.numIndices) * h.indexSize;
+
+        bool valid = std::memcmp(h.magic, meshCacheMagic, sizeof(meshCacheMagic)) == 0 &&
+                h.version == meshCacheVersion &&
+                h.vertexSize == sizeof(scenePipeline::PackedVertex) &&
+                (h.indexSize == sizeof(uint16_t) || h.indexSize == sizeof(uint32_t)) &&
+                mSize == expected &&
+                h.flags == flags &&
+                h.sourceSize == stamp.size &&
+                (h.sourceTime == stamp.time || h.sourceHash == hashSource(source));
+
+        if (!valid) {
+            close();
+        } else if (h.sourceTime != stamp.time) {
+            restampCache(path, offsetof(MeshCacheHeader, sourceTime), stamp.time);
+        }
+        return valid;
+    }
+
+    bool MeshCache::write(std::string const &path, std::string const &source, uint32_t flags,
+            std::vector<glm::vec3> const &positions,
+            std::vector<scenePipeline::PackedVertex> const &attributes,
+            std::vector<uint32_t> const &indices, Aabb const &bounds,
+            MeshOptimizeStats const &stats) {
+        SourceStamp stamp;
+        if (!stampSource(source, stamp)) {
+            return false;
+        }
+
+        MeshCacheHeader h{};
+        std::memcpy(h.magic, meshCacheMagic, sizeof(meshCacheMagic));
+        h.version = meshCacheVersion;
+        h.vertexSize = sizeof(scenePipeline::PackedVertex);
+        h.numVertices = static_cast<uint32_t>(positions.size());
+        h.numIndices = static_cast<uint32_t>(indices.size());
+        h.indexSize = static_cast<uint32_t>(indexSize(positions.size()));
+        h.flags = flags;
+        h.sourceTime = stamp.time;
+        h.sourceSize = stamp.size;
+        h.sourceHash = hashSource(source);
+        for (int i = 0; i != 3; ++i) {
+            h.boundsMin[i] = bounds.min[i];
+            h.boundsMax[i] = bounds.max[i];
+        }
+        h.acmrBefore = stats.acmrBefore;
+        h.acmrAfter = stats.acmrAfter;
+
+        // пишем во временный файл, чтобы прерванная запись не оставила битый кэш
+        auto tmp = tempCachePath(path);
+        bool written;
+        {
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<char const *>(&h), sizeof(h));
+            file.write(reinterpret_cast<char const *>(positions.data()),
+                    static_cast<std::streamsize>(positions.size() * sizeof(glm::vec3)));
+            file.write(reinterpret_cast<char const *>(attributes.data()),
+                    static_cast<std::streamsize>(attributes.size() *
+                            sizeof(scenePipeline::PackedVertex)));
+            if (h.indexSize == sizeof(uint16_t)) {
+                auto narrow = narrowIndices(indices);
+                file.write(reinterpret_cast<char const *>(narrow.data()),
+                        static_cast<std::streamsize>(narrow.size() * sizeof(uint16_t)));
+            } else {
+                file.write(reinterpret_cast<char const *>(indices.data()),
+                        static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+            }
+            file.close();
+            written = !file.fail();
+        }
+        return replaceCache(tmp, path, written);
+    }
+
+    Aabb MeshCache::bounds() const {
+        auto const &h = header();
+        return {{h.boundsMin[0], h.boundsMin[1], h.boundsMin[2]},
+                {h.boundsMax[0], h.boundsMax[1], h.boundsMax[2]}};
+    }
+
+    bool readTextureCache(std::string const &path, std::vector<std::string> const &sources,
+            bool allowCompressed, TextureData &texture) {
+        SourceStamp stamp;
+        if (!stampSources(sources, stamp)) {
+            return false;
+        }
+
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return false;
+        }
+        auto size = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+
+        TextureCacheHeader h{};
+        if (size < sizeof(h) || !file.read(reinterpret_cast<char *>(&h), sizeof(h))) {
+            return false;
+        }
+
+        auto codec = static_cast<TextureCodec>(h.codec);
+        if (std::memcmp(h.magic, textureCacheMagic, sizeof(textureCacheMagic)) != 0 ||
+                h.version != textureCacheVersion || h.codec > uint32_t(TextureCodec::BC5) ||
+                (isCompressed(codec) && !allowCompressed) ||
+                h.width == 0 || h.height == 0 || h.sourceSize != stamp.size) {
+            return false;
+        }
+
+        texture.codec = codec;
+        texture.width = h.width;
+        texture.height = h.height;
+        texture.offsets.clear();
+
+        uint32_t w = h.width;
+        uint32_t height = h.height;
+        size_t total = 0;
+        for (uint32_t i = 0; i != h.levels; ++i) {
+            texture.offsets.push_back(total);
+            total += levelSize(codec, w, height);
+            w = std::max(1u, w / 2);
+            height = std::max(1u, height / 2);
+        }
+        texture.offsets.push_back(total);
+
+        if (h.levels == 0 || size != sizeof(h) + total) {
+            return false;
+        }
+
+        if (h.sourceTime != stamp.time && h.sourceHash != hashSources(sources)) {
+            return false;
+        }
+
+        texture.data.resize(total);
+        if (!file.read(reinterpret_cast<char *>(texture.data.data()),
+                static_cast<std::streamsize>(total))) {
+            return false;
+        }
+
+        if (h.sourceTime != stamp.time) {
+            file.close();
+            restampCache(path, offsetof(TextureCacheHeader, sourceTime), stamp.time);
+        }
+        return true;
+    }
+
+    bool writeTextureCache(std::string const &path, std::vector<std::string> const &sources,
+            TextureData const &texture) {
+        SourceStamp stamp;
+        if (!stampSources(sources, stamp)) {
+            return false;
+        }
+
+        TextureCacheHeader h{};
+        std::memcpy(h.magic, textureCacheMagic, sizeof(textureCacheMagic));
+        h.version = textureCacheVersion;
+        h.codec = static_cast<uint32_t>(texture.codec);
+        h.width = texture.width;
+        h.height = texture.height;
+        h.levels = texture.levels();
+        h.sourceTime = stamp.time;
+        h.sourceSize = stamp.size;
+        h.sourceHash = hashSources(sources);
+
+        auto tmp = tempCachePath(path);
+        bool written;
+        {
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<char const *>(&h), sizeof(h));
+            file.write(reinterpret_cast<char const *>(texture.data.data()),
+                    static_cast<std::streamsize>(texture.data.size()));
+            file.close();
+            written = !file.fail();
+        }
+        return replaceCache(tmp, path, written);
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "pipelines.hpp"
+#include "culling.hpp"
+#include "image.hpp"
+#include "geometry.hpp"
+
+namespace rise::rendering {
+    struct SourceStamp {
+        uint64_t time = 0;
+        uint64_t size = 0;
+    };
+
+    bool stampSource(std::string const &source, SourceStamp &stamp);
+
+    const uint64_t fnvOffset = 14695981039346656037ull;
+
+    // FNV-1a по содержимому файла
+    uint64_t hashSource(std::string const &source);
+
+    uint64_t hashBytes(void const *data, size_t size, uint64_t hash = fnvOffset);
+
+    // абсолютный путь без "." и "..", одинаковый для разных записей одного файла
+    std::string normalizePath(std::string const &path);
+
+    // флаги обработки при импорте: кэш, собранный с другими флагами, считается устаревшим
+    enum MeshCacheFlags : uint32_t {
+        eMeshCacheOptimized = 1,
+    };
+
+    // бинарный кэш меша рядом с исходным файлом: заголовок, поток позиций, поток упакованных
+    // атрибутов и индексы подряд; индексы хранятся 16-битными, если вершин меньше 65536
+    struct MeshCacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t vertexSize;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        uint32_t indexSize;
+        uint32_t flags;
+        uint64_t sourceTime;
+        uint64_t sourceSize;
+        uint64_t sourceHash;
+        float boundsMin[3];
+        float boundsMax[3];
+        // ACMR до и после оптимизации, чтобы статистика не зависела от того, попал ли меш в кэш
+        float acmrBefore;
+        float acmrAfter;
+    };
+
+    class MeshCache {
+    public:
+        MeshCache() = default;
+
+        MeshCache(MeshCache const &) = delete;
+
+        MeshCache &operator=(MeshCache const &) = delete;
+
+        ~MeshCache();
+
+        // отображает кэш в память, если он соответствует исходному файлу и флагам импорта:
+        // при совпадении времени изменения и размера источник не читается, иначе сверяется
+        // его хэш
+        bool open(std::string const &path, std::string const &source, uint32_t flags);
+
+        static bool write(std::string const &path, std::string const &source, uint32_t flags,
+                std::vector<glm::vec3> const &positions,
+                std::vector<scenePipeline::PackedVertex> const &attributes,
+                std::vector<uint32_t> const &indices, Aabb const &bounds,
+                MeshOptimizeStats const &stats);
+
+        MeshCacheHeader const &header() const {
+            return *reinterpret_cast<MeshCacheHeader const *>(mData);
+        }
+
+        glm::vec3 const *positions() const {
+            return reinterpret_cast<glm::vec3 const *>(
+                    static_cast<char const *>(mData) + sizeof(MeshCacheHeader));
+        }
+
+        scenePipeline::PackedVertex const *attributes() const {
+            return reinterpret_cast<scenePipeline::PackedVertex const *>(
+                    positions() + header().numVertices);
+        }
+
+        // uint16_t или uint32_t в зависимости от header().indexSize
+        void const *indices() const {
+            return attributes() + header().numVertices;
+        }
+
+        Aabb bounds() const;
+
+    private:
+        void close();
+
+        void *mData = nullptr;
+        size_t mSize = 0;
+        bool mMapped = false;
+    };
+
+    // кэш текстуры: заголовок и все mip уровни в итоговом формате подряд
+    struct TextureCacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t codec;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levels;
+        uint64_t sourceTime;
+        uint64_t sourceSize;
+        uint64_t sourceHash;
+    };
+
+    // кэш сверяется со всеми исходными файлами, из которых собрана текстура; сжатые форматы
+    // принимаются только при allowCompressed, иначе кэш считается устаревшим
+    bool readTextureCache(std::string const &path, std::vector<std::string> const &sources,
+            bool allowCompressed, TextureData &texture);
+
+    bool writeTextureCache(std::string const &path, std::vector<std::string> const &sources,
+            TextureData const &texture);
+}
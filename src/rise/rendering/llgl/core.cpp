@@ -48,6 +48,7 @@ namespace rise::rendering {
         core.sampler = createSampler(core.renderer.get());
         core.queue = core.renderer->GetCommandQueue();
         core.cmdBuf = core.renderer->CreateCommandBuffer();
+        core.fences.init(core.renderer.get(), scenePipeline::framesInFlight);
 
         auto renderer = state.core.renderer.get();
 
@@ -59,6 +60,15 @@ namespace rise::rendering {
 
     void prepareRender(flecs::entity, ApplicationId app) {
         auto &core = app.id->core;
+        app.id->scene.stats = {};
+        app.id->scene.culling = {};
+
+        ++core.frame;
+        core.fences.wait(core.queue, core.frame);
+        core.completedFrame = core.fences.completed(core.queue);
+        core.releases.retire(core.renderer.get(), core.completedFrame);
+
+        app.id->scene.instances.begin(core.renderer.get(), core.frame, core.completedFrame);
 
         core.cmdBuf->Begin();
     }
@@ -78,7 +88,8 @@ namespace rise::rendering {
     void submitRender(flecs::entity, ApplicationId app) {
         auto &core = app.id->core;
         core.cmdBuf->End();
-        core.queue->Submit(*core.cmdBuf);
+        app.id->scene.instances.end(core.renderer.get());
+        core.fences.submit(core.queue, *core.cmdBuf, core.frame);
         app.id->platform.context->Present();
     }
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "culling.hpp"
+
+#if defined(__SSE__) || defined(_M_X64)
+#define RISE_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace rise::rendering {
+    Aabb transformAabb(Aabb const &local, glm::mat4 const &transform) {
+        if (local.empty()) {
+            return local;
+        }
+
+        glm::vec3 center = (local.min + local.max) * 0.5f;
+        glm::vec3 extent = (local.max - local.min) * 0.5f;
+
+        glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+        glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x +
+                glm::abs(glm::vec3(transform[1])) * extent.y +
+                glm::abs(glm::vec3(transform[2])) * extent.z;
+
+        return {worldCenter - worldExtent, worldCenter + worldExtent};
+    }
+
+    Frustum extractFrustum(glm::mat4 const &viewProjection) {
+        auto row = [&viewProjection](int i) {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i],
+                    viewProjection[3][i]);
+        };
+
+        glm::vec4 planes[8] = {
+                row(3) + row(0), // left
+                row(3) - row(0), // right
+                row(3) + row(1), // bottom
+                row(3) - row(1), // top
+                row(3) + row(2), // near
+                row(3) - row(2), // far
+                {0, 0, 0, 1},
+                {0, 0, 0, 1},
+        };
+
+        Frustum frustum{};
+        for (size_t i = 0; i != 8; ++i) {
+            frustum.x[i] = planes[i].x;
+            frustum.y[i] = planes[i].y;
+            frustum.z[i] = planes[i].z;
+            frustum.w[i] = planes[i].w;
+        }
+        return frustum;
+    }
+
+    bool testBox(Frustum const &frustum, glm::vec3 c, glm::vec3 e) {
+        for (size_t i = 0; i != 6; ++i) {
+            float d = c.x * frustum.x[i] + c.y * frustum.y[i] + c.z * frustum.z[i] + frustum.w[i];
+            float r = e.x * std::abs(frustum.x[i]) + e.y * std::abs(frustum.y[i]) +
+                    e.z * std::abs(frustum.z[i]);
+            if (d + r < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool testAabb(Frustum const &frustum, Aabb const &box) {
+        glm::vec3 c = (box.min + box.max) * 0.5f;
+        glm::vec3 e = (box.max - box.min) * 0.5f;
+
+#ifdef RISE_CULLING_SSE
+        __m128 cx = _mm_set1_ps(c.x);
+        __m128 cy = _mm_set1_ps(c.y);
+        __m128 cz = _mm_set1_ps(c.z);
+        __m128 ex = _mm_set1_ps(e.x);
+        __m128 ey = _mm_set1_ps(e.y);
+        __m128 ez = _mm_set1_ps(e.z);
+        __m128 sign = _mm_set1_ps(-0.0f);
+        __m128 zero = _mm_setzero_ps();
+
+        for (size_t i = 0; i != 8; i += 4) {
+            __m128 px = _mm_load_ps(frustum.x + i);
+            __m128 py = _mm_load_ps(frustum.y + i);
+            __m128 pz = _mm_load_ps(frustum.z + i);
+            __m128 pw = _mm_load_ps(frustum.w + i);
+
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, px), _mm_mul_ps(cy, py)),
+                    _mm_add_ps(_mm_mul_ps(cz, pz), pw));
+            __m128 r = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(ex, _mm_andnot_ps(sign, px)),
+                    _mm_mul_ps(ey, _mm_andnot_ps(sign, py))),
+                    _mm_mul_ps(ez, _mm_andnot_ps(sign, pz)));
+
+            if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(d, r), zero))) {
+                return false;
+            }
+        }
+        return true;
+#else
+        return testBox(frustum, c, e);
+#endif
+    }
+
+    void CullBatch::resize(size_t count) {
+        for (auto array : {&cx, &cy, &cz, &ex, &ey, &ez}) {
+            array->resize(count);
+        }
+        visible.resize(count);
+    }
+
+    void CullBatch::cull(Frustum const &frustum, size_t begin, size_t end) {
+        cullAabbs(frustum, cx.data() + begin, cy.data() + begin, cz.data() + begin,
+                ex.data() + begin, ey.data() + begin, ez.data() + begin, end - begin,
+                visible.data() + begin);
+    }
+
+    void cullAabbs(Frustum const &frustum, float const *cx, float const *cy, float const *cz,
+            float const *ex, float const *ey, float const *ez, size_t count, uint8_t *visible) {
+        size_t i = 0;
+
+#ifdef RISE_CULLING_SSE
+        __m128 sign = _mm_set1_ps(-0.0f);
+        __m128 zero = _mm_setzero_ps();
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 bcx = _mm_loadu_ps(cx + i);
+            __m128 bcy = _mm_loadu_ps(cy + i);
+            __m128 bcz = _mm_loadu_ps(cz + i);
+            __m128 bex = _mm_loadu_ps(ex + i);
+            __m128 bey = _mm_loadu_ps(ey + i);
+            __m128 bez = _mm_loadu_ps(ez + i);
+            __m128 outside = _mm_setzero_ps();
+
+            for (size_t p = 0; p != 6; ++p) {
+                __m128 px = _mm_set1_ps(frustum.x[p]);
+                __m128 py = _mm_set1_ps(frustum.y[p]);
+                __m128 pz = _mm_set1_ps(frustum.z[p]);
+                __m128 pw = _mm_set1_ps(frustum.w[p]);
+
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bcx, px), _mm_mul_ps(bcy, py)),
+                        _mm_add_ps(_mm_mul_ps(bcz, pz), pw));
+                __m128 r = _mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(bex, _mm_andnot_ps(sign, px)),
+                        _mm_mul_ps(bey, _mm_andnot_ps(sign, py))),
+                        _mm_mul_ps(bez, _mm_andnot_ps(sign, pz)));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+            }
+
+            int mask = _mm_movemask_ps(outside);
+            visible[i + 0] = !(mask & 1);
+            visible[i + 1] = !(mask & 2);
+            visible[i + 2] = !(mask & 4);
+            visible[i + 3] = !(mask & 8);
+        }
+#endif
+
+        for (; i != count; ++i) {
+            visible[i] = testBox(frustum, {cx[i], cy[i], cz[i]}, {ex[i], ey[i], ez[i]});
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+namespace rise::rendering {
+    struct Aabb {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+        bool empty() const {
+            return min.x > max.x;
+        }
+
+        void expand(glm::vec3 point) {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+    };
+
+    // плоскости frustum в виде SoA, 6 плоскостей дополнены до 8 всегда проходящими
+    struct Frustum {
+        alignas(16) float x[8];
+        alignas(16) float y[8];
+        alignas(16) float z[8];
+        alignas(16) float w[8];
+    };
+
+    // боксы для cullAabbs: центры и половины размеров, каждая компонента в своём массиве
+    struct CullBatch {
+        std::vector<float> cx, cy, cz;
+        std::vector<float> ex, ey, ez;
+        std::vector<uint8_t> visible;
+
+        void resize(size_t count);
+
+        // пустой бокс (меш ещё не загружен) проходит любую проверку
+        void set(size_t i, Aabb const &box) {
+            if (box.empty()) {
+                cx[i] = cy[i] = cz[i] = 0.0f;
+                ex[i] = ey[i] = ez[i] = std::numeric_limits<float>::max();
+                return;
+            }
+            cx[i] = (box.min.x + box.max.x) * 0.5f;
+            cy[i] = (box.min.y + box.max.y) * 0.5f;
+            cz[i] = (box.min.z + box.max.z) * 0.5f;
+            ex[i] = (box.max.x - box.min.x) * 0.5f;
+            ey[i] = (box.max.y - box.min.y) * 0.5f;
+            ez[i] = (box.max.z - box.min.z) * 0.5f;
+        }
+
+        // cullAabbs для [begin, end), результат в visible
+        void cull(Frustum const &frustum, size_t begin, size_t end);
+    };
+
+    // боксов на задачу при параллельном отборе
+    constexpr size_t cullGrain = 4096;
+
+    Aabb transformAabb(Aabb const &local, glm::mat4 const &transform);
+
+    Frustum extractFrustum(glm::mat4 const &viewProjection);
+
+    bool testAabb(Frustum const &frustum, Aabb const &box);
+
+    // пакетная проверка count боксов в SoA (центры и половины размеров), visible[i] = 0 или 1
+    void cullAabbs(Frustum const &frustum, float const *cx, float const *cy, float const *cz,
+            float const *ex, float const *ey, float const *ez, size_t count, uint8_t *visible);
+
+    inline bool testSphere(Aabb const &box, glm::vec3 point, float distance) {
+        glm::vec3 center = (box.min + box.max) * 0.5f;
+        float radius = glm::length(box.max - box.min) * 0.5f;
+        return glm::length(center - point) - radius <= distance;
+    }
+}
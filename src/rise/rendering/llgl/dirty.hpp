@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <mutex>
+#include <flecs.h>
+
+namespace rise::rendering {
+    // битовая маска по индексам слотов: слот попадает в список изменённых один раз за кадр,
+    // сброс проходит только по отмеченным словам
+    class DirtySlots {
+    public:
+        // false - слот уже отмечен в этом кадре
+        bool mark(unsigned slot) {
+            size_t word = slot / 64;
+            uint64_t bit = uint64_t(1) << (slot % 64);
+            if (word >= mBits.size()) {
+                mBits.resize(word + 1, 0);
+            }
+            if (mBits[word] & bit) {
+                return false;
+            }
+            mBits[word] |= bit;
+            mMarked.push_back(slot);
+            return true;
+        }
+
+        bool marked(unsigned slot) const {
+            size_t word = slot / 64;
+            return word < mBits.size() && (mBits[word] & (uint64_t(1) << (slot % 64)));
+        }
+
+        std::vector<unsigned> const &slots() const {
+            return mMarked;
+        }
+
+        void clear() {
+            for (auto slot : mMarked) {
+                mBits[slot / 64] = 0;
+            }
+            mMarked.clear();
+        }
+
+    private:
+        std::vector<uint64_t> mBits;
+        std::vector<unsigned> mMarked;
+    };
+
+    struct ChangeStats {
+        uint32_t events = 0;
+        // повторные события той же сущности за кадр, которые не дали повторной обработки
+        uint32_t coalesced = 0;
+
+        ChangeStats &operator+=(ChangeStats const &other) {
+            events += other.events;
+            coalesced += other.coalesced;
+            return *this;
+        }
+    };
+
+    // сущности, изменённые за кадр, без повторов. Метка поколения по индексу сущности
+    // отличает уже добавленные, поэтому сброс - это только смена поколения. push вызывают
+    // OnSet системы, в том числе с рабочих потоков flecs, остальное - главный поток вне
+    // конвейера
+    class ChangeList {
+    public:
+        using const_iterator = std::vector<flecs::entity>::const_iterator;
+
+        // false - сущность уже есть в списке этого кадра
+        bool push(flecs::entity e) {
+            std::lock_guard lock(mMutex);
+            ++mStats.events;
+            auto index = static_cast<uint32_t>(e.id());
+            if (index >= mStamps.size()) {
+                mStamps.resize(index + 1);
+            }
+            auto &stamp = mStamps[index];
+            if (stamp.generation == mGeneration) {
+                // индекс мог перейти к новой сущности после удаления прежней
+                mEntities[stamp.position] = e;
+                ++mStats.coalesced;
+                return false;
+            }
+            stamp = {mGeneration, static_cast<uint32_t>(mEntities.size())};
+            mEntities.push_back(e);
+            return true;
+        }
+
+        const_iterator begin() const { return mEntities.begin(); }
+
+        const_iterator end() const { return mEntities.end(); }
+
+        size_t size() const { return mEntities.size(); }
+
+        bool empty() const { return mEntities.empty(); }
+
+        ChangeStats const &stats() const {
+            return mStats;
+        }
+
+        void clear() {
+            mEntities.clear();
+            mStats = {};
+            if (++mGeneration == 0) {
+                std::fill(mStamps.begin(), mStamps.end(), Stamp{});
+                mGeneration = 1;
+            }
+        }
+
+    private:
+        struct Stamp {
+            uint32_t generation = 0;
+            uint32_t position = 0;
+        };
+
+        std::mutex mMutex;
+        std::vector<flecs::entity> mEntities;
+        std::vector<Stamp> mStamps;
+        uint32_t mGeneration = 1;
+        ChangeStats mStats;
+    };
+}
@@ -0,0 +1,360 @@
+#include "geometry.hpp"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace rise::rendering {
+    using Vertex = scenePipeline::Vertex;
+
+    const size_t vertexComponents = sizeof(Vertex) / sizeof(float);
+    static_assert(sizeof(Vertex) == vertexComponents * sizeof(float));
+
+    const uint32_t emptySlot = ~0u;
+
+    // отбрасываем младшие биты мантиссы с округлением, чтобы склеивались вершины,
+    // отличающиеся только погрешностью текстового формата; -0 и 0 совпадают
+    inline uint32_t quantize(float value) {
+        if (value == 0.0f) {
+            return 0;
+        }
+
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits + 0x8u) & ~0xFu;
+    }
+
+    inline void quantize(Vertex const &vertex, uint32_t (&key)[vertexComponents]) {
+        float components[vertexComponents];
+        std::memcpy(components, &vertex, sizeof(Vertex));
+        for (size_t i = 0; i != vertexComponents; ++i) {
+            key[i] = quantize(components[i]);
+        }
+    }
+
+    inline uint64_t hashKey(uint32_t const (&key)[vertexComponents]) {
+        uint64_t hash = 0x9E3779B97F4A7C15ull;
+        for (auto v : key) {
+            hash = (hash ^ v) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 32;
+        }
+        return hash;
+    }
+
+    VertexWelder::VertexWelder(size_t numIndices) {
+        size_t capacity = 16;
+        while (capacity < numIndices * 2) {
+            capacity *= 2;
+        }
+
+        mTable.assign(capacity, emptySlot);
+        mMask = capacity - 1;
+        // у типичного меша на вершину приходится несколько индексов
+        mKeys.reserve(numIndices / 4 * vertexComponents);
+        vertices.reserve(numIndices / 4);
+        indices.reserve(numIndices);
+    }
+
+    uint32_t VertexWelder::add(Vertex const &vertex) {
+        uint32_t key[vertexComponents];
+        quantize(vertex, key);
+
+        size_t slot = hashKey(key) & mMask;
+        while (mTable[slot] != emptySlot) {
+            auto other = mKeys.data() + size_t(mTable[slot]) * vertexComponents;
+            if (std::memcmp(key, other, sizeof(key)) == 0) {
+                indices.push_back(mTable[slot]);
+                return mTable[slot];
+            }
+            slot = (slot + 1) & mMask;
+        }
+
+        auto index = static_cast<uint32_t>(vertices.size());
+        mTable[slot] = index;
+        mKeys.insert(mKeys.end(), key, key + vertexComponents);
+        vertices.push_back(vertex);
+        indices.push_back(index);
+        return index;
+    }
+}
+
+namespace rise::rendering {
+    float computeAcmr(std::vector<uint32_t> const &indices, size_t numVertices,
+            size_t cacheSize) {
+        if (indices.empty()) {
+            return 0;
+        }
+
+        // FIFO: вершина в кэше, если была добавлена не раньше чем cacheSize промахов назад
+        std::vector<size_t> timestamps(numVertices, 0);
+        size_t time = cacheSize + 1;
+        size_t misses = 0;
+
+        for (auto index : indices) {
+            if (time - timestamps[index] > cacheSize) {
+                timestamps[index] = time++;
+                ++misses;
+            }
+        }
+        return float(misses) / float(indices.size() / 3);
+    }
+
+    namespace forsyth {
+        const size_t cacheSize = 32;
+        const float cacheDecayPower = 1.5f;
+        const float lastTriScore = 0.75f;
+        const float valenceBoostScale = 2.0f;
+        const float valenceBoostPower = 0.5f;
+
+        float vertexScore(int cachePosition, uint32_t remaining) {
+            if (remaining == 0) {
+                return -1.0f;
+            }
+
+            float score = 0;
+            if (cachePosition >= 0) {
+                if (cachePosition < 3) {
+                    score = lastTriScore;
+                } else {
+                    float scaler = 1.0f / float(cacheSize - 3);
+                    score = std::pow(1.0f - float(cachePosition - 3) * scaler, cacheDecayPower);
+                }
+            }
+            return score + valenceBoostScale * std::pow(float(remaining), -valenceBoostPower);
+        }
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t> &indices, size_t numVertices) {
+        size_t numTriangles = indices.size() / 3;
+        if (numTriangles == 0) {
+            return;
+        }
+
+        // смежность вершина -> треугольники в виде CSR
+        std::vector<uint32_t> offsets(numVertices + 1, 0);
+        for (auto index : indices) {
+            ++offsets[index + 1];
+        }
+        for (size_t i = 0; i != numVertices; ++i) {
+            offsets[i + 1] += offsets[i];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> remaining(numVertices, 0);
+        for (size_t t = 0; t != numTriangles; ++t) {
+            for (size_t k = 0; k != 3; ++k) {
+                auto v = indices[t * 3 + k];
+                adjacency[offsets[v] + remaining[v]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        std::vector<int> cachePosition(numVertices, -1);
+        std::vector<float> vertexScores(numVertices);
+        for (size_t v = 0; v != numVertices; ++v) {
+            vertexScores[v] = forsyth::vertexScore(-1, remaining[v]);
+        }
+
+        std::vector<float> triangleScores(numTriangles);
+        std::vector<uint8_t> emitted(numTriangles, 0);
+        for (size_t t = 0; t != numTriangles; ++t) {
+            triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+                    vertexScores[indices[t * 3 + 2]];
+        }
+
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> nextCache;
+        cache.reserve(forsyth::cacheSize + 3);
+        nextCache.reserve(forsyth::cacheSize + 3);
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        size_t cursor = 0;
+        size_t best = 0;
+        for (size_t t = 1; t != numTriangles; ++t) {
+            if (triangleScores[t] > triangleScores[best]) {
+                best = t;
+            }
+        }
+
+        for (size_t n = 0; n != numTriangles; ++n) {
+            if (best == numTriangles) {
+                // у вершин в кэше не осталось треугольников, берём следующий по порядку
+                while (emitted[cursor]) {
+                    ++cursor;
+                }
+                best = cursor;
+            }
+
+            emitted[best] = 1;
+            nextCache.clear();
+            for (size_t k = 0; k != 3; ++k) {
+                auto v = indices[best * 3 + k];
+                result.push_back(v);
+                nextCache.push_back(v);
+
+                // убираем треугольник из списка смежности вершины
+                auto begin = adjacency.begin() + offsets[v];
+                auto end = begin + remaining[v];
+                *std::find(begin, end, static_cast<uint32_t>(best)) = *(end - 1);
+                --remaining[v];
+            }
+
+            for (auto v : cache) {
+                if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2]) {
+                    nextCache.push_back(v);
+                }
+            }
+            std::swap(cache, nextCache);
+
+            // вытесненные вершины теряют бонус кэша
+            for (size_t i = forsyth::cacheSize; i < cache.size(); ++i) {
+                cachePosition[cache[i]] = -1;
+                vertexScores[cache[i]] = forsyth::vertexScore(-1, remaining[cache[i]]);
+            }
+            if (cache.size() > forsyth::cacheSize) {
+                cache.resize(forsyth::cacheSize);
+            }
+
+            for (size_t i = 0; i != cache.size(); ++i) {
+                cachePosition[cache[i]] = static_cast<int>(i);
+                vertexScores[cache[i]] = forsyth::vertexScore(static_cast<int>(i),
+                        remaining[cache[i]]);
+            }
+
+            best = numTriangles;
+            float bestScore = -1.0f;
+            for (auto v : cache) {
+                for (uint32_t i = 0; i != remaining[v]; ++i) {
+                    auto t = adjacency[offsets[v] + i];
+                    float score = vertexScores[indices[t * 3]] +
+                            vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                    triangleScores[t] = score;
+                    if (score > bestScore) {
+                        bestScore = score;
+                        best = t;
+                    }
+                }
+            }
+        }
+
+        indices = std::move(result);
+    }
+
+    void optimizeVertexFetch(std::vector<scenePipeline::Vertex> &vertices,
+            std::vector<uint32_t> &indices) {
+        std::vector<uint32_t> remap(vertices.size(), emptySlot);
+        std::vector<scenePipeline::Vertex> result;
+        result.reserve(vertices.size());
+
+        for (auto &index : indices) {
+            if (remap[index] == emptySlot) {
+                remap[index] = static_cast<uint32_t>(result.size());
+                result.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices = std::move(result);
+    }
+
+    MeshOptimizeStats optimizeMesh(std::vector<scenePipeline::Vertex> &vertices,
+            std::vector<uint32_t> &indices) {
+        MeshOptimizeStats stats;
+        stats.acmrBefore = computeAcmr(indices, vertices.size());
+        stats.bytesBefore = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t);
+
+        optimizeVertexCache(indices, vertices.size());
+        optimizeVertexFetch(vertices, indices);
+
+        stats.acmrAfter = computeAcmr(indices, vertices.size());
+        stats.bytesAfter = vertices.size() *
+                (sizeof(glm::vec3) + sizeof(scenePipeline::PackedVertex)) +
+                indices.size() * indexSize(vertices.size());
+        return stats;
+    }
+}
+
+namespace rise::rendering {
+    std::array<int16_t, 2> encodeOctahedral(glm::vec3 normal) {
+        float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (length == 0) {
+            return {0, 0};
+        }
+
+        float x = normal.x / length;
+        float y = normal.y / length;
+        if (normal.z < 0) {
+            float ox = (1.0f - std::abs(y)) * (x >= 0 ? 1.0f : -1.0f);
+            float oy = (1.0f - std::abs(x)) * (y >= 0 ? 1.0f : -1.0f);
+            x = ox;
+            y = oy;
+        }
+
+        auto snorm = [](float v) {
+            return static_cast<int16_t>(std::round(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+        };
+        return {snorm(x), snorm(y)};
+    }
+
+    uint16_t floatToHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        int32_t exponent = int32_t((bits >> 23) & 0xFFu) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+
+        if (exponent >= 31) {
+            // переполнение и inf, NaN сохраняет ненулевую мантиссу
+            bool nan = ((bits >> 23) & 0xFFu) == 0xFFu && mantissa != 0;
+            return static_cast<uint16_t>(sign | 0x7C00u | (nan ? 0x200u : 0u));
+        }
+
+        if (exponent <= 0) {
+            if (exponent < -10) {
+                return static_cast<uint16_t>(sign);
+            }
+
+            // денормализованное число
+            mantissa |= 0x800000u;
+            uint32_t shift = uint32_t(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            if ((mantissa >> (shift - 1)) & 1u) {
+                ++half;
+            }
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+        if (mantissa & 0x1000u) {
+            ++half;
+        }
+        return static_cast<uint16_t>(half);
+    }
+
+    void packVertices(std::vector<scenePipeline::Vertex> const &vertices,
+            std::vector<glm::vec3> &positions, std::vector<scenePipeline::PackedVertex> &packed) {
+        positions.resize(vertices.size());
+        packed.resize(vertices.size());
+
+        auto unorm = [](float v) {
+            return static_cast<uint8_t>(std::round(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+        };
+
+        for (size_t i = 0; i != vertices.size(); ++i) {
+            auto const &vertex = vertices[i];
+            auto &p = packed[i];
+            positions[i] = vertex.pos;
+
+            auto normal = encodeOctahedral(vertex.normal);
+            p.normal[0] = normal[0];
+            p.normal[1] = normal[1];
+            p.texCoord[0] = floatToHalf(vertex.texCoord.x);
+            p.texCoord[1] = floatToHalf(vertex.texCoord.y);
+            p.color[0] = unorm(vertex.color.x);
+            p.color[1] = unorm(vertex.color.y);
+            p.color[2] = unorm(vertex.color.z);
+            p.color[3] = 255;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <array>
+#include "pipelines.hpp"
+
+namespace rise::rendering {
+    // сварка вершин: вершины с одинаковыми после квантования атрибутами получают общий индекс;
+    // таблица с открытой адресацией резервируется один раз по числу индексов меша
+    class VertexWelder {
+    public:
+        explicit VertexWelder(size_t numIndices);
+
+        uint32_t add(scenePipeline::Vertex const &vertex);
+
+        std::vector<scenePipeline::Vertex> vertices;
+        std::vector<uint32_t> indices;
+
+    private:
+        std::vector<uint32_t> mTable;
+        std::vector<uint32_t> mKeys;
+        size_t mMask = 0;
+    };
+
+    struct MeshOptimizeStats {
+        float acmrBefore = 0;
+        float acmrAfter = 0;
+        size_t bytesBefore = 0;
+        size_t bytesAfter = 0;
+    };
+
+    // итоги импорта мешей для окна статистики, ACMR суммируется по мешам, в том числе
+    // прочитанным из кэша
+    struct MeshImportStats {
+        uint32_t parsed = 0;
+        uint32_t cached = 0;
+        float acmrBefore = 0;
+        float acmrAfter = 0;
+        size_t bytesSaved = 0;
+
+        uint32_t meshes() const {
+            return parsed + cached;
+        }
+    };
+
+    // среднее число промахов FIFO кэша вершин на треугольник
+    float computeAcmr(std::vector<uint32_t> const &indices, size_t numVertices,
+            size_t cacheSize = 16);
+
+    // переупорядочивание треугольников по алгоритму Форсайта для кэша после трансформации
+    void optimizeVertexCache(std::vector<uint32_t> &indices, size_t numVertices);
+
+    // вершины в порядке первого обращения из индексного буфера, неиспользуемые удаляются
+    void optimizeVertexFetch(std::vector<scenePipeline::Vertex> &vertices,
+            std::vector<uint32_t> &indices);
+
+    MeshOptimizeStats optimizeMesh(std::vector<scenePipeline::Vertex> &vertices,
+            std::vector<uint32_t> &indices);
+
+    std::array<int16_t, 2> encodeOctahedral(glm::vec3 normal);
+
+    uint16_t floatToHalf(float value);
+
+    // раскладывает вершины на поток позиций и поток упакованных атрибутов
+    void packVertices(std::vector<scenePipeline::Vertex> const &vertices,
+            std::vector<glm::vec3> &positions, std::vector<scenePipeline::PackedVertex> &packed);
+
+    // меши до 65536 вершин используют 16-битные индексы
+    inline size_t indexSize(size_t numVertices) {
+        return numVertices <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    inline std::vector<uint16_t> narrowIndices(std::vector<uint32_t> const &indices) {
+        return std::vector<uint16_t>(indices.begin(), indices.end());
+    }
+}
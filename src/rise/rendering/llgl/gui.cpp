@@ -12,16 +12,35 @@ namespace rise::rendering {
         style.Colors[ImGuiCol_CheckMark] = ImVec4(0.0f, 1.0f, 0.0f, 1.0f);
     }
 
-    void initGuiPipeline(CoreState const &core, GuiState &gui, std::string const& root) {
+    void initGuiPipeline(CoreState &core, GuiState &gui, std::string const& root) {
         gui.format.AppendAttribute(LLGL::VertexAttribute{"inPos", LLGL::Format::RG32Float});
         gui.format.AppendAttribute(LLGL::VertexAttribute{"inUV", LLGL::Format::RG32Float});
         gui.format.AppendAttribute(LLGL::VertexAttribute{"inColor", LLGL::Format::RGBA8UNorm});
 
         gui.layout = guiPipeline::createLayout(core.renderer.get());
 
-        auto program = createShaderProgram(core.renderer.get(),
-                root + "/shaders/gui", gui.format);
-        gui.pipeline = guiPipeline::createPipeline(core.renderer.get(), gui.layout, program);
+        gui.shaders = root + "/shaders/gui";
+        gui.program = createShaderProgram(core.renderer.get(), gui.shaders, {gui.format});
+        gui.pipeline = guiPipeline::createPipeline(core.renderer.get(), gui.layout, gui.program);
+        watchShaders(core.watcher, gui.shaders);
+    }
+
+    void reloadGuiShaders(ApplicationState &state, std::vector<std::string> const &changed) {
+        auto &core = state.core;
+        auto &gui = state.gui;
+        if (!shadersChanged(changed, gui.shaders)) {
+            return;
+        }
+
+        auto program = reloadShaderProgram(core.renderer.get(), gui.shaders, {gui.format});
+        if (!program) {
+            return;
+        }
+
+        core.releases.push(gui.pipeline, core.frame);
+        core.releases.push(gui.program, core.frame);
+        gui.program = program;
+        gui.pipeline = guiPipeline::createPipeline(core.renderer.get(), gui.layout, gui.program);
     }
 
     void initGuiState(flecs::entity e, ApplicationState &state, Path const& path) {
@@ -100,9 +119,7 @@ namespace rise::rendering {
         auto renderer = core.renderer.get();
 
         if (mesh.numVertices != imDrawData->TotalVtxCount) {
-            if (mesh.vertices) {
-                renderer->Release(*mesh.vertices);
-            }
+            core.releases.push(mesh.vertices, core.frame);
             mesh.numVertices = imDrawData->TotalVtxCount;
             mesh.vertices = createVertexBuffer(renderer, gui.format, vertices);
         } else {
@@ -111,9 +128,7 @@ namespace rise::rendering {
         }
 
         if (mesh.numIndices != imDrawData->TotalIdxCount) {
-            if (mesh.indices) {
-                renderer->Release(*mesh.indices);
-            }
+            core.releases.push(mesh.indices, core.frame);
             mesh.numIndices = imDrawData->TotalIdxCount;
             mesh.indices = createIndexBuffer(renderer, indices);
         } else {
@@ -137,6 +152,87 @@ namespace rise::rendering {
         ImGui::NewFrame();
     }
 
+    void drawRegistryStats(char const *name, RegistryStats const &stats) {
+        ImGui::Text("%s: %zu resources, %zu references", name, stats.resources,
+                stats.references);
+        ImGui::Text("  same path: %zu, same content: %zu, bytes deduplicated: %zu",
+                stats.pathHits, stats.contentHits, stats.bytesDeduplicated);
+    }
+
+    // счётчики кадра в одном окне: очередь отрисовки, отсечение, кольцевой буфер, отложенные
+    // удаления, события изменений и арена очередей команд
+    void drawStatistics(flecs::entity, ApplicationId app, GuiContext context) {
+        ImGui::SetCurrentContext(context.context);
+        ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Statistics")) {
+            ImGui::End();
+            return;
+        }
+
+        auto const &scene = app.id->scene;
+        auto const &manager = app.id->manager;
+
+        if (ImGui::CollapsingHeader("Render queue", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto const &queue = scene.stats;
+            ImGui::Text("packets: %u, draws: %u, instances: %u", queue.packets, queue.draws,
+                    queue.instances);
+            ImGui::Text("pipeline / heap / mesh changes: %u / %u / %u", queue.pipelineChanges,
+                    queue.heapChanges, queue.meshChanges);
+            ImGui::Text("redundant changes removed: %u", queue.removedChanges);
+            ImGui::Text("sort key overflows: %u", queue.keyOverflows);
+        }
+
+        if (ImGui::CollapsingHeader("Culling", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto const &culling = scene.culling;
+            ImGui::Text("scene visible / culled: %u / %u", culling.visible, culling.culled);
+            ImGui::Text("shadow visible / culled: %u / %u", culling.shadowVisible,
+                    culling.shadowCulled);
+        }
+
+        if (ImGui::CollapsingHeader("Instance ring", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto const &ring = scene.instances.stats();
+            ImGui::Text("maps: %u, allocations: %u, bytes: %llu", ring.maps, ring.allocations,
+                    static_cast<unsigned long long>(ring.bytes));
+            ImGui::Text("overflows: %u, fallbacks: %u, fallback bytes: %llu", ring.overflows,
+                    ring.fallbacks, static_cast<unsigned long long>(ring.fallbackBytes));
+        }
+
+        if (ImGui::CollapsingHeader("Releases", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto const &releases = app.id->core.releases.stats();
+            ImGui::Text("deferred: %u, retired: %u, pending: %u", releases.deferred,
+                    releases.retired, releases.pending);
+        }
+
+        if (ImGui::CollapsingHeader("Shared resources", ImGuiTreeNodeFlags_DefaultOpen)) {
+            drawRegistryStats("textures", manager.texture.registry.stats());
+            drawRegistryStats("meshes", manager.mesh.registry.stats());
+        }
+
+        if (ImGui::CollapsingHeader("Mesh import", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto const &imports = manager.mesh.imports;
+            ImGui::Text("parsed: %u, from cache: %u", imports.parsed, imports.cached);
+            if (imports.meshes() != 0) {
+                auto count = static_cast<float>(imports.meshes());
+                ImGui::Text("mean ACMR: %.3f -> %.3f", imports.acmrBefore / count,
+                        imports.acmrAfter / count);
+            }
+            ImGui::Text("bytes saved on parse: %zu", imports.bytesSaved);
+        }
+
+        if (ImGui::CollapsingHeader("Changes", ImGuiTreeNodeFlags_DefaultOpen)) {
+            ImGui::Text("events: %u, coalesced: %u", manager.changes.events,
+                    manager.changes.coalesced);
+        }
+
+        if (ImGui::CollapsingHeader("Frame arena", ImGuiTreeNodeFlags_DefaultOpen)) {
+            auto const &allocations = manager.allocations;
+            ImGui::Text("allocations: %u, bytes: %zu, new blocks: %u", allocations.allocations,
+                    allocations.bytes, allocations.blocks);
+        }
+
+        ImGui::End();
+    }
+
     void processImGui(flecs::entity, GuiContext context) {
         ImGui::SetCurrentContext(context.context);
         ImGui::Render();
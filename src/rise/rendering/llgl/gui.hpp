@@ -11,7 +11,11 @@ namespace rise::rendering {
 
     void prepareImgui(flecs::entity, ApplicationId app, GuiContext context);
 
+    void drawStatistics(flecs::entity, ApplicationId app, GuiContext context);
+
     void processImGui(flecs::entity, GuiContext context);
 
     void renderGui(flecs::entity, ApplicationId app, GuiContext context, Extent2D size);
+
+    void reloadGuiShaders(ApplicationState &state, std::vector<std::string> const &changed);
 }
\ No newline at end of file
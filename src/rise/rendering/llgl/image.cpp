@@ -0,0 +1,296 @@
+#include "image.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace rise::rendering {
+    size_t levelSize(TextureCodec codec, uint32_t width, uint32_t height) {
+        size_t blocks = size_t((width + 3) / 4) * size_t((height + 3) / 4);
+        switch (codec) {
+            case TextureCodec::R8:
+                return size_t(width) * height;
+            case TextureCodec::RG8:
+                return size_t(width) * height * 2;
+            case TextureCodec::RGBA8:
+                return size_t(width) * height * 4;
+            case TextureCodec::BC1:
+            case TextureCodec::BC4:
+                return blocks * 8;
+            case TextureCodec::BC3:
+            case TextureCodec::BC5:
+                return blocks * 16;
+        }
+        return 0;
+    }
+
+    // уменьшение вдвое средним по 2x2, нечётная сторона повторяет последний пиксель
+    std::vector<uint8_t> downsample(std::vector<uint8_t> const &src, uint32_t width,
+            uint32_t height, uint32_t channels) {
+        uint32_t w = std::max(1u, width / 2);
+        uint32_t h = std::max(1u, height / 2);
+        std::vector<uint8_t> dst(size_t(w) * h * channels);
+
+        for (uint32_t y = 0; y != h; ++y) {
+            uint32_t y0 = std::min(y * 2, height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, height - 1);
+            auto row0 = src.data() + size_t(y0) * width * channels;
+            auto row1 = src.data() + size_t(y1) * width * channels;
+            auto out = dst.data() + size_t(y) * w * channels;
+
+            for (uint32_t x = 0; x != w; ++x) {
+                uint32_t x0 = std::min(x * 2, width - 1) * channels;
+                uint32_t x1 = std::min(x * 2 + 1, width - 1) * channels;
+                for (uint32_t c = 0; c != channels; ++c) {
+                    uint32_t sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                    out[x * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+        return dst;
+    }
+
+    inline uint16_t toRgb565(int r, int g, int b) {
+        return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 |
+                ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+    }
+
+    inline void fromRgb565(uint16_t c, int *rgb) {
+        int r = (c >> 11) & 31;
+        int g = (c >> 5) & 63;
+        int b = c & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    void encodeBc1Block(uint8_t const *rgba, uint8_t *block) {
+        int lo[3] = {255, 255, 255};
+        int hi[3] = {0, 0, 0};
+        for (int i = 0; i != 16; ++i) {
+            for (int c = 0; c != 3; ++c) {
+                lo[c] = std::min<int>(lo[c], rgba[i * 4 + c]);
+                hi[c] = std::max<int>(hi[c], rgba[i * 4 + c]);
+            }
+        }
+
+        // концы отрезка сдвигаются внутрь ограничивающего бокса на 1/16
+        for (int c = 0; c != 3; ++c) {
+            int inset = (hi[c] - lo[c]) / 16;
+            lo[c] = std::min(255, lo[c] + inset);
+            hi[c] = std::max(0, hi[c] - inset);
+        }
+
+        uint16_t c0 = toRgb565(hi[0], hi[1], hi[2]);
+        uint16_t c1 = toRgb565(lo[0], lo[1], lo[2]);
+        if (c0 < c1) {
+            std::swap(c0, c1);
+        }
+
+        int palette[4][3];
+        fromRgb565(c0, palette[0]);
+        fromRgb565(c1, palette[1]);
+        for (int c = 0; c != 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        uint32_t indices = 0;
+        if (c0 != c1) {
+            for (int i = 0; i != 16; ++i) {
+                int best = 0;
+                int bestDistance = 1 << 30;
+                for (int p = 0; p != 4; ++p) {
+                    int distance = 0;
+                    for (int c = 0; c != 3; ++c) {
+                        int d = rgba[i * 4 + c] - palette[p][c];
+                        distance += d * d;
+                    }
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= uint32_t(best) << (i * 2);
+            }
+        }
+
+        block[0] = static_cast<uint8_t>(c0);
+        block[1] = static_cast<uint8_t>(c0 >> 8);
+        block[2] = static_cast<uint8_t>(c1);
+        block[3] = static_cast<uint8_t>(c1 >> 8);
+        std::memcpy(block + 4, &indices, sizeof(indices));
+    }
+
+    void encodeBc4Block(uint8_t const *values, uint8_t *block) {
+        int lo = 255;
+        int hi = 0;
+        for (int i = 0; i != 16; ++i) {
+            lo = std::min<int>(lo, values[i]);
+            hi = std::max<int>(hi, values[i]);
+        }
+
+        block[0] = static_cast<uint8_t>(hi);
+        block[1] = static_cast<uint8_t>(lo);
+
+        // при hi > lo восемь значений: hi, lo и шесть промежуточных
+        int palette[8] = {hi, lo};
+        for (int p = 1; p != 7; ++p) {
+            palette[p + 1] = ((7 - p) * hi + p * lo) / 7;
+        }
+
+        uint64_t indices = 0;
+        if (hi != lo) {
+            for (int i = 0; i != 16; ++i) {
+                int best = 0;
+                int bestDistance = 256;
+                for (int p = 0; p != 8; ++p) {
+                    int distance = std::abs(values[i] - palette[p]);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= uint64_t(best) << (i * 3);
+            }
+        }
+
+        for (int i = 0; i != 6; ++i) {
+            block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+        }
+    }
+
+    void compressLevel(TextureCodec codec, uint8_t const *src, uint32_t width, uint32_t height,
+            uint32_t channels, uint8_t *dst) {
+        for (uint32_t by = 0; by < height; by += 4) {
+            for (uint32_t bx = 0; bx < width; bx += 4) {
+                // блок на краю дополняется повтором последних пикселей
+                uint8_t texels[16 * 4];
+                for (uint32_t i = 0; i != 16; ++i) {
+                    uint32_t x = std::min(bx + i % 4, width - 1);
+                    uint32_t y = std::min(by + i / 4, height - 1);
+                    std::memcpy(texels + i * channels, src + (size_t(y) * width + x) * channels,
+                            channels);
+                }
+
+                if (codec == TextureCodec::BC1) {
+                    encodeBc1Block(texels, dst);
+                    dst += 8;
+                } else if (codec == TextureCodec::BC3) {
+                    uint8_t alpha[16];
+                    for (int i = 0; i != 16; ++i) {
+                        alpha[i] = texels[i * 4 + 3];
+                    }
+                    encodeBc4Block(alpha, dst);
+                    encodeBc1Block(texels, dst + 8);
+                    dst += 16;
+                } else if (codec == TextureCodec::BC4) {
+                    encodeBc4Block(texels, dst);
+                    dst += 8;
+                } else {
+                    uint8_t r[16];
+                    uint8_t g[16];
+                    for (int i = 0; i != 16; ++i) {
+                        r[i] = texels[i * 2];
+                        g[i] = texels[i * 2 + 1];
+                    }
+                    encodeBc4Block(r, dst);
+                    encodeBc4Block(g, dst + 8);
+                    dst += 16;
+                }
+            }
+        }
+    }
+
+    std::vector<uint8_t> packChannels(std::array<ChannelSource, 3> const &channels,
+            uint32_t &width, uint32_t &height) {
+        width = 0;
+        height = 0;
+        for (auto const &channel : channels) {
+            if (channel.pixels && width == 0) {
+                width = channel.width;
+                height = channel.height;
+            }
+        }
+
+        std::vector<uint8_t> pixels(size_t(width) * height * 3);
+        for (size_t c = 0; c != channels.size(); ++c) {
+            auto const &channel = channels[c];
+            for (uint32_t y = 0; y != height; ++y) {
+                uint32_t sy = channel.pixels ? uint32_t(uint64_t(y) * channel.height / height) : 0;
+                for (uint32_t x = 0; x != width; ++x) {
+                    auto &out = pixels[(size_t(y) * width + x) * 3 + c];
+                    if (channel.pixels) {
+                        uint32_t sx = uint32_t(uint64_t(x) * channel.width / width);
+                        out = channel.pixels[size_t(sy) * channel.width + sx];
+                    } else {
+                        out = channel.fill;
+                    }
+                }
+            }
+        }
+        return pixels;
+    }
+
+    TextureData buildTexture(uint8_t const *pixels, uint32_t width, uint32_t height,
+            uint32_t components, bool compress, TextureContent content) {
+        bool expand = content == TextureContent::Color && components < 3;
+        uint32_t channels = components >= 3 || expand ? 4 : components;
+        std::vector<uint8_t> level(size_t(width) * height * channels);
+
+        bool opaque = true;
+        for (size_t i = 0; i != size_t(width) * height; ++i) {
+            if (expand) {
+                // серый и серый с прозрачностью
+                uint8_t gray = pixels[i * components];
+                uint8_t alpha = components == 2 ? pixels[i * 2 + 1] : 255;
+                level[i * 4] = level[i * 4 + 1] = level[i * 4 + 2] = gray;
+                level[i * 4 + 3] = alpha;
+                opaque = opaque && alpha == 255;
+            } else if (components == 3) {
+                std::memcpy(&level[i * 4], pixels + i * 3, 3);
+                level[i * 4 + 3] = 255;
+            } else {
+                std::memcpy(&level[i * channels], pixels + i * channels, channels);
+                opaque = opaque && (components != 4 || pixels[i * 4 + 3] == 255);
+            }
+        }
+
+        TextureData texture;
+        texture.width = width;
+        texture.height = height;
+        if (channels == 1) {
+            texture.codec = compress ? TextureCodec::BC4 : TextureCodec::R8;
+        } else if (channels == 2) {
+            texture.codec = compress ? TextureCodec::BC5 : TextureCodec::RG8;
+        } else if (compress) {
+            texture.codec = opaque ? TextureCodec::BC1 : TextureCodec::BC3;
+        } else {
+            texture.codec = TextureCodec::RGBA8;
+        }
+
+        uint32_t w = width;
+        uint32_t h = height;
+        while (true) {
+            size_t offset = texture.data.size();
+            texture.offsets.push_back(offset);
+            texture.data.resize(offset + levelSize(texture.codec, w, h));
+
+            if (isCompressed(texture.codec)) {
+                compressLevel(texture.codec, level.data(), w, h, channels,
+                        texture.data.data() + offset);
+            } else {
+                std::memcpy(texture.data.data() + offset, level.data(), level.size());
+            }
+
+            if (w == 1 && h == 1) {
+                break;
+            }
+
+            level = downsample(level, w, h, channels);
+            w = std::max(1u, w / 2);
+            h = std::max(1u, h / 2);
+        }
+        texture.offsets.push_back(texture.data.size());
+
+        return texture;
+    }
+}
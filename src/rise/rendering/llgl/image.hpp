@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace rise::rendering {
+    // формат хранения текстуры: одно- и двухканальные карты данных не расширяются до RGBA
+    enum class TextureCodec : uint32_t {
+        R8,
+        RG8,
+        RGBA8,
+        BC1,
+        BC3,
+        BC4,
+        BC5,
+    };
+
+    // полная цепочка mip уровней в одном буфере, offsets[i] - начало уровня i
+    struct TextureData {
+        TextureCodec codec = TextureCodec::RGBA8;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> data;
+        std::vector<size_t> offsets;
+
+        uint32_t levels() const {
+            return offsets.empty() ? 0 : static_cast<uint32_t>(offsets.size() - 1);
+        }
+    };
+
+    inline bool isCompressed(TextureCodec codec) {
+        return codec >= TextureCodec::BC1;
+    }
+
+    size_t levelSize(TextureCodec codec, uint32_t width, uint32_t height);
+
+    // цвет читается шейдером как rgb, поэтому серое изображение расширяется до RGB(A);
+    // данные (упакованные карты) сохраняют число каналов
+    enum class TextureContent {
+        Color,
+        Data,
+    };
+
+    // строит mip уровни фильтром 2x2 и при compress сжимает их в BC: 1 канал данных - BC4,
+    // 2 канала данных - BC5, цвет - BC1, цвет с прозрачностью - BC3
+    TextureData buildTexture(uint8_t const *pixels, uint32_t width, uint32_t height,
+            uint32_t components, bool compress, TextureContent content);
+
+    struct ChannelSource {
+        uint8_t const *pixels = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint8_t fill = 255;
+    };
+
+    // упаковывает одноканальные карты в каналы RGB по размеру первой загруженной; карта другого
+    // размера масштабируется ближайшим соседом, отсутствующая заполняется значением fill
+    std::vector<uint8_t> packChannels(std::array<ChannelSource, 3> const &channels,
+            uint32_t &width, uint32_t &height);
+
+    // блок 4x4: rgba - 64 байта, values - 16 значений одного канала
+    void encodeBc1Block(uint8_t const *rgba, uint8_t *block);
+
+    void encodeBc4Block(uint8_t const *values, uint8_t *block);
+}
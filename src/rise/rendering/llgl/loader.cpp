@@ -0,0 +1,112 @@
+#include "loader.hpp"
+#include "cache.hpp"
+#include "stb_image.h"
+#include <cassert>
+#include <iostream>
+
+namespace rise::rendering {
+    ImageLoader::~ImageLoader() {
+        // оставшиеся в очереди задачи завершаются сразу, дожидаться нужно только начатых
+        mStop = true;
+        if (mJobs) {
+            mJobs->waitBackground(mPending);
+        }
+    }
+
+    void ImageLoader::push(std::string file) {
+        LoadedImage request;
+        request.file = std::move(file);
+        enqueue(std::move(request));
+    }
+
+    void ImageLoader::pushPacked(std::string file, std::vector<std::string> channels) {
+        LoadedImage request;
+        request.file = std::move(file);
+        request.channels = std::move(channels);
+        enqueue(std::move(request));
+    }
+
+    void ImageLoader::enqueue(LoadedImage request) {
+        assert(mJobs && "ImageLoader needs a JobSystem");
+        mJobs->runBackground(mPending, [this, request = std::move(request)] {
+            if (!mStop) {
+                load(request);
+            }
+        });
+    }
+
+    void ImageLoader::poll(std::vector<LoadedImage> &images) {
+        std::lock_guard lock(mMutex);
+        images.insert(images.end(), mDone.begin(), mDone.end());
+        mDone.clear();
+    }
+
+    void ImageLoader::load(LoadedImage image) {
+        image.loaded = decode(image, mCompress);
+        if (image.loaded) {
+            auto const &texture = image.texture;
+            uint32_t shape[] = {uint32_t(texture.codec), texture.width, texture.height};
+            image.hash = hashBytes(texture.data.data(), texture.data.size(),
+                    hashBytes(shape, sizeof(shape)));
+        }
+
+        std::lock_guard lock(mMutex);
+        mDone.push_back(std::move(image));
+    }
+
+    bool ImageLoader::decode(LoadedImage &image, bool compress) {
+        auto cacheFile = image.file + ".rtex";
+        auto sources = image.channels.empty() ? std::vector{image.file} : image.channels;
+        if (readTextureCache(cacheFile, sources, compress, image.texture)) {
+            return true;
+        }
+
+        if (image.channels.empty()) {
+            int width = 0;
+            int height = 0;
+            int components = 0;
+            auto pixels = stbi_load(image.file.c_str(), &width, &height, &components, 0);
+            if (!pixels) {
+                return false;
+            }
+
+            image.texture = buildTexture(pixels, static_cast<uint32_t>(width),
+                    static_cast<uint32_t>(height), static_cast<uint32_t>(components), compress,
+                    TextureContent::Color);
+            stbi_image_free(pixels);
+        } else {
+            std::array<ChannelSource, 3> channels;
+            bool any = false;
+            for (size_t i = 0; i != channels.size() && i != image.channels.size(); ++i) {
+                int width = 0;
+                int height = 0;
+                int components = 0;
+                channels[i].pixels = stbi_load(image.channels[i].c_str(), &width, &height,
+                        &components, 1);
+                channels[i].width = static_cast<uint32_t>(width);
+                channels[i].height = static_cast<uint32_t>(height);
+                any = any || channels[i].pixels;
+            }
+
+            uint32_t width = 0;
+            uint32_t height = 0;
+            auto pixels = packChannels(channels, width, height);
+            for (auto &channel : channels) {
+                if (channel.pixels) {
+                    stbi_image_free(const_cast<uint8_t *>(channel.pixels));
+                }
+            }
+
+            if (!any) {
+                return false;
+            }
+            image.texture = buildTexture(pixels.data(), width, height, 3, compress,
+                    TextureContent::Data);
+        }
+
+        if (!writeTextureCache(cacheFile, sources, image.texture)) {
+            std::cerr << "failed to write texture cache: " << cacheFile << std::endl;
+        }
+        return true;
+    }
+}
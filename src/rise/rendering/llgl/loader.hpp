@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "util/soa.hpp"
+#include "util/jobs.hpp"
+#include "image.hpp"
+
+namespace rise::rendering {
+    struct LoadedImage {
+        std::string file;
+        // при непустом channels изображение собирается из трёх одноканальных карт,
+        // а file задаёт только имя кэша
+        std::vector<std::string> channels;
+        bool loaded = false;
+        // хэш итоговых данных текстуры для поиска одинаковых изображений по разным путям
+        uint64_t hash = 0;
+        TextureData texture;
+    };
+
+    // чтение, декодирование, построение mip уровней и сжатие изображений фоновыми задачами
+    // JobSystem; результат кэшируется рядом с файлом в .rtex, готовые изображения забираются
+    // потоком рендера, который и загружает их в видеопамять
+    class ImageLoader {
+    public:
+        ImageLoader() = default;
+
+        ImageLoader(ImageLoader const &) = delete;
+
+        ImageLoader &operator=(ImageLoader const &) = delete;
+
+        ~ImageLoader();
+
+        void push(std::string file);
+
+        void pushPacked(std::string file, std::vector<std::string> channels);
+
+        void poll(std::vector<LoadedImage> &images);
+
+        // включается, если устройство поддерживает BC форматы
+        void setCompression(bool compress) {
+            mCompress = compress;
+        }
+
+        // пул должен пережить загрузчик: деструктор ждёт его задачи
+        void setJobs(JobSystem &jobs) {
+            mJobs = &jobs;
+        }
+
+    private:
+        void enqueue(LoadedImage request);
+
+        void load(LoadedImage image);
+
+        bool decode(LoadedImage &image, bool compress);
+
+        JobSystem *mJobs = nullptr;
+        JobCounter mPending;
+        std::mutex mMutex;
+        std::vector<LoadedImage> mDone;
+        std::atomic<bool> mStop = false;
+        std::atomic<bool> mCompress = false;
+    };
+}
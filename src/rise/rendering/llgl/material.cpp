@@ -14,13 +14,13 @@ namespace rise::rendering {
         if (id.id == NullKey) {
             auto &core = app.ref->id->core;
 
-            std::tuple init{MaterialState{}, std::set<flecs::entity_t>{}};
+            std::tuple init{MaterialState{}, ModelLinks{}};
 
             id.id = app.ref->id->manager.material.states.push_back(std::move(init));
             e.add_trait<Initialized, MaterialId>();
             auto uniform = createUniformBuffer<scenePipeline::PerMaterial>(core.renderer.get());
             app.ref->id->manager.material.toInit.emplace_back(MaterialState{uniform}, id);
-            app.ref->id->manager.material.toUpdate.push_back(e);
+            app.ref->id->manager.material.toUpdate.push(e);
         } else {
             app.ref->id->manager.material.toRemove.push_back(id);
         }
@@ -38,8 +38,8 @@ namespace rise::rendering {
     }
 
     void catchMaterialUpdate(flecs::entity e, ApplicationRef app) {
-            auto &manager = app.ref->id->manager;
-            manager.material.toUpdate.push_back(e);
+        auto &manager = app.ref->id->manager;
+        manager.material.toUpdate.push(mainWorldEntity(app, e));
     }
 
     void updateMaterial(flecs::entity, ApplicationId app) {
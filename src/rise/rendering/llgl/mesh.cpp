@@ -1,15 +1,20 @@
 #include "mesh.hpp"
 #include "utils.hpp"
+#include "cache.hpp"
+#include "geometry.hpp"
 #include <tiny_obj_loader.h>
 
 
 namespace rise::rendering {
     std::pair<std::vector<scenePipeline::Vertex>, std::vector<uint32_t>> loadObjMesh(
             tinyobj::attrib_t const &attrib, std::vector<tinyobj::shape_t> const &shapes) {
-        std::vector <scenePipeline::Vertex> vertices;
-        std::vector <uint32_t> indices;
+        size_t numIndices = 0;
+        for (const auto &shape : shapes) {
+            numIndices += shape.mesh.indices.size();
+        }
 
-        std::unordered_map <scenePipeline::Vertex, uint32_t> uniqueVertices{};
+        VertexWelder welder(numIndices);
+        bool hasColors = attrib.colors.size() >= attrib.vertices.size();
 
         for (const auto &shape : shapes) {
             for (const auto &idx : shape.mesh.indices) {
@@ -18,29 +23,28 @@ namespace rise::rendering {
                 vertex.pos.x = attrib.vertices[3 * idx.vertex_index + 0];
                 vertex.pos.y = attrib.vertices[3 * idx.vertex_index + 1];
                 vertex.pos.z = attrib.vertices[3 * idx.vertex_index + 2];
-                vertex.normal.x = attrib.normals[3 * idx.normal_index + 0];
-                vertex.normal.y = attrib.normals[3 * idx.normal_index + 1];
-                vertex.normal.z = attrib.normals[3 * idx.normal_index + 2];
-                vertex.color.x = attrib.colors[3 * idx.vertex_index + 0];
-                vertex.color.y = attrib.colors[3 * idx.vertex_index + 1];
-                vertex.color.z = attrib.colors[3 * idx.vertex_index + 2];
-                vertex.texCoord = {
-                        attrib.texcoords[2 * idx.texcoord_index + 0],
-                        1.0f - attrib.texcoords[2 * idx.texcoord_index + 1]
-                };
-                vertices.push_back(vertex);
-
-                if (uniqueVertices.count(vertex) == 0) {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
+                if (idx.normal_index >= 0) {
+                    vertex.normal.x = attrib.normals[3 * idx.normal_index + 0];
+                    vertex.normal.y = attrib.normals[3 * idx.normal_index + 1];
+                    vertex.normal.z = attrib.normals[3 * idx.normal_index + 2];
+                }
+                if (hasColors) {
+                    vertex.color.x = attrib.colors[3 * idx.vertex_index + 0];
+                    vertex.color.y = attrib.colors[3 * idx.vertex_index + 1];
+                    vertex.color.z = attrib.colors[3 * idx.vertex_index + 2];
+                }
+                if (idx.texcoord_index >= 0) {
+                    vertex.texCoord = {
+                            attrib.texcoords[2 * idx.texcoord_index + 0],
+                            1.0f - attrib.texcoords[2 * idx.texcoord_index + 1]
+                    };
                 }
 
-                indices.push_back(uniqueVertices[vertex]);
-
+                welder.add(vertex);
             }
         }
 
-        return {vertices, indices};
+        return {std::move(welder.vertices), std::move(welder.indices)};
     }
 
     void regMesh(flecs::entity e) {
@@ -51,7 +55,8 @@ namespace rise::rendering {
 
     void initMesh(flecs::entity e, ApplicationRef app, MeshId &id) {
         if (!e.has_trait<Initialized, MeshId>()) {
-            id.id = app.ref->id->manager.mesh.states.push_back(std::tuple{MeshState{}});
+            id.id = app.ref->id->manager.mesh.states.push_back(
+                    std::tuple{MeshState{}, ModelLinks{}});
             e.add_trait<Initialized, MeshId>();
             e.patch<Path>([](auto) {});
         }
@@ -66,13 +71,83 @@ namespace rise::rendering {
 
     void removeMesh(flecs::entity, ApplicationRef app, MeshId id) {
         app.ref->id->manager.mesh.toRemove.push_back(id);
+        app.ref->id->manager.mesh.registry.cancel(id.id);
     }
 
-    void updateObjMesh(flecs::entity, ApplicationRef ref, MeshId meshId, Path const &path) {
-        auto &core = ref.ref->id->core;
-        auto &scene = ref.ref->id->scene;
-        auto &manager = ref.ref->id->manager;
-        auto file = ref.ref.entity().get<Path>()->file + "/models/" + path.file;
+    MeshState createMesh(ApplicationState &app, glm::vec3 const *positions,
+            scenePipeline::PackedVertex const *attributes, size_t numVertices,
+            void const *indices, size_t numIndices, size_t indexSize, Aabb const &bounds) {
+        auto renderer = app.core.renderer.get();
+        auto &scene = app.scene;
+
+        MeshState mesh;
+        mesh.vertices = createVertexBuffer(renderer, scene.format, positions, numVertices);
+        mesh.attributes = createVertexBuffer(renderer, scene.attributeFormat, attributes,
+                numVertices);
+        if (indexSize == sizeof(uint16_t)) {
+            mesh.indices = createIndexBuffer(renderer, static_cast<uint16_t const *>(indices),
+                    numIndices);
+        } else {
+            mesh.indices = createIndexBuffer(renderer, static_cast<uint32_t const *>(indices),
+                    numIndices);
+        }
+        mesh.numIndices = static_cast<uint32_t>(numIndices);
+        mesh.bounds = bounds;
+
+        LLGL::Buffer *sceneBuffers[] = {mesh.vertices, mesh.attributes, scene.instances.buffer()};
+        mesh.instanced = renderer->CreateBufferArray(3, sceneBuffers);
+
+        LLGL::Buffer *shadowBuffers[] = {mesh.vertices, scene.instances.buffer()};
+        mesh.shadowInstanced = renderer->CreateBufferArray(2, shadowBuffers);
+
+        return mesh;
+    }
+
+    // меш с тем же содержимым, загруженный из другого файла, не создаётся повторно
+    void uploadMesh(ApplicationState &app, std::string const &file, glm::vec3 const *positions,
+            scenePipeline::PackedVertex const *attributes, size_t numVertices,
+            void const *indices, size_t numIndices, size_t indexSize, Aabb const &bounds) {
+        auto &meshes = app.manager.mesh;
+
+        size_t positionsSize = numVertices * sizeof(glm::vec3);
+        size_t attributesSize = numVertices * sizeof(scenePipeline::PackedVertex);
+        size_t indicesSize = numIndices * indexSize;
+        uint64_t hash = hashBytes(indices, indicesSize, hashBytes(attributes, attributesSize,
+                hashBytes(positions, positionsSize)));
+
+        MeshState mesh;
+        if (auto shared = meshes.registry.findHash(hash)) {
+            mesh = shared->value;
+        } else {
+            mesh = createMesh(app, positions, attributes, numVertices, indices, numIndices,
+                    indexSize, bounds);
+        }
+
+        auto users = meshes.registry.complete(file, mesh, mesh.vertices, hash,
+                positionsSize + attributesSize + indicesSize);
+        for (auto user : users) {
+            meshes.registry.retain(mesh.vertices);
+            meshes.toInit.emplace_back(mesh, MeshId{user});
+        }
+    }
+
+    void loadMeshFile(ApplicationState &app, std::string const &file) {
+        auto &meshes = app.manager.mesh;
+        auto cacheFile = file + ".rmesh";
+
+        // разобранный меш хранится рядом с исходником и при следующих запусках
+        // отображается в память без разбора текста
+        uint32_t flags = app.scene.optimizeMeshes ? eMeshCacheOptimized : 0;
+        MeshCache cache;
+        if (cache.open(cacheFile, file, flags)) {
+            auto const &header = cache.header();
+            ++meshes.imports.cached;
+            meshes.imports.acmrBefore += header.acmrBefore;
+            meshes.imports.acmrAfter += header.acmrAfter;
+            uploadMesh(app, file, cache.positions(), cache.attributes(), header.numVertices,
+                    cache.indices(), header.numIndices, header.indexSize, cache.bounds());
+            return;
+        }
 
         tinyobj::ObjReaderConfig readerConfig;
         readerConfig.triangulate = true;
@@ -84,6 +159,7 @@ namespace rise::rendering {
             if (!reader.Error().empty()) {
                 std::string err = "TinyObjReader: " + reader.Error();
                 std::cerr << err << std::endl;
+                meshes.registry.fail(file);
                 return;
             }
         }
@@ -95,20 +171,43 @@ namespace rise::rendering {
         auto[vertices, indices] = loadObjMesh(reader.GetAttrib(), reader.GetShapes());
         if (vertices.empty() || indices.empty()) {
             std::cout << "Loading mesh error: " << file << std::endl;
+            meshes.registry.fail(file);
             return;
         }
 
-        MeshState mesh;
-        if (mesh.vertices && mesh.indices) {
-            core.renderer->Release(*mesh.vertices);
-            core.renderer->Release(*mesh.indices);
+        MeshOptimizeStats stats;
+        if (app.scene.optimizeMeshes) {
+            stats = optimizeMesh(vertices, indices);
+            meshes.imports.bytesSaved += stats.bytesBefore - stats.bytesAfter;
+        } else {
+            stats.acmrBefore = stats.acmrAfter = computeAcmr(indices, vertices.size());
         }
+        ++meshes.imports.parsed;
+        meshes.imports.acmrBefore += stats.acmrBefore;
+        meshes.imports.acmrAfter += stats.acmrAfter;
+
+        std::vector<glm::vec3> positions;
+        std::vector<scenePipeline::PackedVertex> attributes;
+        packVertices(vertices, positions, attributes);
 
-        mesh.vertices = createVertexBuffer(core.renderer.get(), scene.format, vertices);
-        mesh.indices = createIndexBuffer(core.renderer.get(), indices);
-        mesh.numIndices = static_cast<uint32_t>(indices.size());
+        Aabb bounds;
+        for (auto const &position : positions) {
+            bounds.expand(position);
+        }
 
-        manager.mesh.toInit.emplace_back(mesh, meshId);
+        if (!MeshCache::write(cacheFile, file, flags, positions, attributes, indices, bounds,
+                stats)) {
+            std::cerr << "failed to write mesh cache: " << cacheFile << std::endl;
+        }
+
+        if (indexSize(positions.size()) == sizeof(uint16_t)) {
+            auto narrow = narrowIndices(indices);
+            uploadMesh(app, file, positions.data(), attributes.data(), positions.size(),
+                    narrow.data(), narrow.size(), sizeof(uint16_t), bounds);
+        } else {
+            uploadMesh(app, file, positions.data(), attributes.data(), positions.size(),
+                    indices.data(), indices.size(), sizeof(uint32_t), bounds);
+        }
     }
 
 //
@@ -142,6 +241,63 @@ namespace rise::rendering {
 //
 //    }
 
+    void updateObjMesh(flecs::entity, ApplicationRef ref, MeshId meshId, Path const &path) {
+        auto &app = *ref.ref->id;
+        auto &meshes = app.manager.mesh;
+        auto file = normalizePath(ref.ref.entity().get<Path>()->file + "/models/" + path.file);
+
+        // файл уже загружен для другой сущности
+        ResourceRegistry<MeshState>::Entry const *entry = nullptr;
+        if (meshes.registry.request(file, meshId.id, entry)) {
+            app.core.watcher.watch(file);
+            loadMeshFile(app, file);
+        } else if (entry->ready) {
+            meshes.registry.retain(entry->identity);
+            meshes.toInit.emplace_back(entry->value, meshId);
+        }
+    }
+
+    // кэш устаревает вместе с исходником, поэтому изменённый файл разбирается заново
+    void reloadMeshes(ApplicationState &app, std::vector<std::string> const &changed) {
+        for (auto const &file : changed) {
+            if (app.manager.mesh.registry.reload(file)) {
+                loadMeshFile(app, file);
+            }
+        }
+
+        for (auto const &file : app.manager.mesh.registry.takeDirty()) {
+            if (app.manager.mesh.registry.reload(file)) {
+                loadMeshFile(app, file);
+            }
+        }
+    }
+
+    // новое состояние меша несёт другие границы, поэтому матрицы и AABB его моделей
+    // пересчитываются в том же кадре
+    void prepareMeshUpdate(flecs::entity e, ApplicationId app) {
+        auto &manager = app.id->manager;
+        auto ecs = e.world();
+        std::vector<flecs::entity_t> stale;
+
+        for (auto const &up : manager.mesh.toInit) {
+            auto &models = std::get<eMeshModels>(manager.mesh.states.at(up.second.id)).get();
+            stale.clear();
+            for (auto id : models) {
+                flecs::entity model(ecs, id);
+                auto meshId = model.get<MeshId>();
+                if (meshId && meshId->id == up.second.id &&
+                        model.has_trait<Initialized, ModelId>()) {
+                    manager.model.toUpdateTransform.push(model);
+                } else {
+                    stale.push_back(id);
+                }
+            }
+            for (auto id : stale) {
+                models.erase(id);
+            }
+        }
+    }
+
     void regMeshToModel(flecs::entity e, ApplicationRef app, ModelId model) {
         if (model.id != NullKey) {
             auto &manager = app.ref->id->manager;
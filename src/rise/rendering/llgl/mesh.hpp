@@ -4,4 +4,8 @@
 
 namespace rise::rendering {
     void importMesh(flecs::world& ecs);
+
+    void prepareMeshUpdate(flecs::entity e, ApplicationId app);
+
+    void reloadMeshes(ApplicationState &app, std::vector<std::string> const &changed);
 }
\ No newline at end of file
@@ -1,11 +1,13 @@
 #include "model.hpp"
 #include "../glm.hpp"
 #include "utils.hpp"
+#include "transform.hpp"
 
 namespace rise::rendering {
     void regModel(flecs::entity e) {
         if (!e.has<Position3D>()) e.set<Position3D>({0.0f, 0.0f, 0.0f});
         if (!e.has<Rotation3D>()) e.set<Rotation3D>({0.0f, 0.0f, 0.0f});
+        if (!e.has<Orientation3D>()) e.set<Orientation3D>({0.0f, 0.0f, 0.0f, 1.0f});
         if (!e.has<Scale3D>()) e.set<Scale3D>({1.0f, 1.0f, 1.0f});
         e.set<ModelId>({});
         e.set_trait<Previous, MaterialId>({flecs::entity(0)});
@@ -22,23 +24,13 @@ namespace rise::rendering {
             if (!e.has<MaterialId>()) e.add_instanceof(presets.material);
             if (!e.has<MeshId>()) e.add_instanceof(presets.mesh);
             if (!e.has<AlbedoTexture>()) e.set<AlbedoTexture>({presets.texture});
-            if (!e.has<MetallicTexture>()) e.set<MetallicTexture>({presets.texture});
-            if (!e.has<RoughnessTexture>()) e.set<RoughnessTexture>({presets.texture});
-            if (!e.has<AoTexture>()) e.set<AoTexture>({presets.texture});
+            if (!e.has<PackedOrmTexture>()) e.set<PackedOrmTexture>({presets.texture});
 
-            auto uniform = createUniformBuffer<scenePipeline::PerObject>(
-                    app->core.renderer.get());
             id.id = app->manager.model.states.push_back(
-                    std::tuple{ModelState{uniform}, std::set<flecs::entity_t>{}});
+                    std::tuple{ModelState{}, ModelLinks{}, Aabb{}, uint8_t(1)});
             e.add_trait<Initialized, ModelId>();
-            app->manager.model.toUpdateTransform.push_back(e.id());
+            app->manager.model.toUpdateTransform.push(e);
             app->manager.model.toUpdateDescriptors.push_back(e.id());
-
-            for (auto &&light : app->manager.light.states) {
-                auto &model = std::get<eLightShadowModels>(light).get();
-                model.emplace(id.id, ShadowModel{});
-                app->manager.light.toInitShadowModels.push_back(id);
-            }
             e.set<ModelInitialized>({true});
         }
     }
@@ -54,21 +46,36 @@ namespace rise::rendering {
     void removeModel(flecs::entity, ApplicationRef ref, ModelId id) {
         auto app = ref.ref->id;
         app->manager.model.toRemove.push_back(id);
-        app->manager.light.toRemoveShadowModels.push_back(id);
+    }
+
+    void releaseModelHeap(ApplicationState &app, ModelState &model) {
+        if (!model.heap) {
+            return;
+        }
+
+        auto &heaps = app.manager.model.heaps;
+        auto it = heaps.find(model.resources);
+        if (it != heaps.end() && --it->second.refs == 0) {
+            app.core.releases.push(it->second.heap, app.core.frame);
+            heaps.erase(it);
+        }
+        model.heap = nullptr;
     }
 
     void clearDescriptors(flecs::entity e, ApplicationId app) {
         auto &manager = app.id->manager;
-        auto &core = app.id->core;
 
-        for (auto irm : manager.model.toUpdateDescriptors) {
+        auto &models = manager.model;
+        for (auto irm : models.toUpdateDescriptors) {
             flecs::entity rm(e.world(), irm);
-            auto &model = std::get<eModelState>(
-                    manager.model.states.at(rm.get<ModelId>()->id)).get();
-            if (model.heap) {
-                core.renderer->Release(*model.heap);
-                model.heap = nullptr;
+            auto id = rm.get<ModelId>();
+            if (!id || id->id == NullKey || !models.dirtyDescriptors.mark(id->id.first)) {
+                continue;
             }
+
+            models.descriptorsToRebuild.push_back(irm);
+            auto &model = std::get<eModelState>(models.states.at(id->id)).get();
+            releaseModelHeap(*app.id, model);
         }
     }
 
@@ -85,79 +92,157 @@ namespace rise::rendering {
         return diffuseId;
     }
 
+    LLGL::ResourceHeap *createModelHeap(ApplicationState &app, ViewportState const &viewport,
+            ModelResourceKeys const &resources) {
+        auto &manager = app.manager;
+        auto const &material = std::get<eMaterialState>(
+                manager.material.states.at(resources[1])).get();
+        auto const &diffuse = std::get<eTextureState>(
+                manager.texture.states.at(resources[2])).get();
+        auto const &orm = std::get<eTextureState>(
+                manager.texture.states.at(resources[3])).get();
+
+        LLGL::ResourceHeapDescriptor resourceHeapDesc;
+        resourceHeapDesc.pipelineLayout = app.scene.layout;
+        resourceHeapDesc.resourceViews.emplace_back(viewport.uniform);
+        resourceHeapDesc.resourceViews.emplace_back(material.uniform);
+        resourceHeapDesc.resourceViews.emplace_back(app.core.sampler);
+        for (auto texture : {diffuse.val, orm.val}) {
+            resourceHeapDesc.resourceViews.emplace_back(
+                    texture ? texture : manager.texture.placeholder);
+        }
+        resourceHeapDesc.resourceViews.emplace_back(viewport.cubeMaps);
+        resourceHeapDesc.resourceViews.emplace_back(app.shadows.sampler);
+        return app.core.renderer->CreateResourceHeap(resourceHeapDesc);
+    }
+
     void recreateDescriptors(flecs::entity e, ApplicationId app) {
         auto &manager = app.id->manager;
-        auto &core = app.id->core;
 
-        for (auto iup : manager.model.toUpdateDescriptors) {
+        for (auto iup : manager.model.descriptorsToRebuild) {
             flecs::entity up(e.world(), iup);
             auto &model = std::get<eModelState>(
                     manager.model.states.at(up.get<ModelId>()->id)).get();
             if (!model.heap) {
+                auto viewportId = getViewport(up);
+                auto materialId = *up.get<MaterialId>();
                 auto const &viewport = std::get<eViewportState>(
-                        manager.viewport.states.at(getViewport(up).id)).get();
+                        manager.viewport.states.at(viewportId.id)).get();
                 TextureId diffuseId = getTexId<AlbedoTexture>(up, e, app);
-                TextureId metallicId = getTexId<MetallicTexture>(up, e, app);
-                TextureId roughnessId = getTexId<RoughnessTexture>(up, e, app);
-                TextureId aoId = getTexId<AoTexture>(up, e, app);
-
-                auto const &diffuse = std::get<eTextureState>(
-                        manager.texture.states.at(diffuseId.id)).get();
-                auto const &metallic = std::get<eTextureState>(
-                        manager.texture.states.at(metallicId.id)).get();
-                auto const &roughness = std::get<eTextureState>(
-                        manager.texture.states.at(roughnessId.id)).get();
-                auto const &ao = std::get<eTextureState>(
-                        manager.texture.states.at(aoId.id)).get();
-
-                auto const &material = std::get<eMaterialState>(
-                        manager.material.states.at(up.get<MaterialId>()->id)).get();
-
-                LLGL::ResourceHeapDescriptor resourceHeapDesc;
-                resourceHeapDesc.pipelineLayout = app.id->scene.layout;
-                resourceHeapDesc.resourceViews.emplace_back(viewport.uniform);
-                resourceHeapDesc.resourceViews.emplace_back(material.uniform);
-                resourceHeapDesc.resourceViews.emplace_back(model.uniform);
-                resourceHeapDesc.resourceViews.emplace_back(core.sampler);
-                resourceHeapDesc.resourceViews.emplace_back(diffuse.val);
-                resourceHeapDesc.resourceViews.emplace_back(metallic.val);
-                resourceHeapDesc.resourceViews.emplace_back(roughness.val);
-                resourceHeapDesc.resourceViews.emplace_back(ao.val);
-                resourceHeapDesc.resourceViews.emplace_back(viewport.cubeMaps);
-                resourceHeapDesc.resourceViews.emplace_back(app.id->shadows.sampler);
-                model.heap = core.renderer->CreateResourceHeap(resourceHeapDesc);
+                TextureId ormId = getTexId<PackedOrmTexture>(up, e, app);
+
+                ModelResourceKeys resources{viewportId.id, materialId.id, diffuseId.id,
+                        ormId.id};
+                auto &shared = manager.model.heaps[resources];
+                if (!shared.heap) {
+                    shared.heap = createModelHeap(*app.id, viewport, resources);
+                }
+                ++shared.refs;
+
+                model.heap = shared.heap;
+                model.resources = resources;
             }
         }
     }
 
-    void updateTransform(flecs::entity e, ApplicationId app) {
+    void updateTransform(flecs::entity, ApplicationId app) {
         auto &manager = app.id->manager;
+        auto &models = manager.model;
+        auto &batch = models.transformBatch;
 
-        for (auto iup : manager.model.toUpdateTransform) {
-            flecs::entity up(e.world(), iup);
+        // сначала собираются компоненты всех изменённых моделей, матрицы строятся одним пакетом
+        batch.clear();
+        models.transformTargets.clear();
+        for (auto up : models.toUpdateTransform) {
             if (up.has_trait<Initialized, ModelId>()) {
-                auto &model = std::get<eModelState>(
-                        manager.model.states.at(up.get<ModelId>()->id)).get();
-
                 auto position = *getOrDefault(up, Position3D{0, 0, 0});
-                auto rotation = *getOrDefault(up, Rotation3D{0, 0, 0});
+                auto orientation = *getOrDefault(up, Orientation3D{0, 0, 0, 1});
                 auto scale = *getOrDefault(up, Scale3D{1, 1, 1});
+                batch.push(toGlm(position), toGlm(orientation), toGlm(scale));
 
-                glm::mat4 mat = glm::translate(glm::mat4(1), toGlm(position));
-                float angle = std::max({rotation.x, rotation.y, rotation.z});
-                if (angle != 0) {
-                    mat = glm::rotate(mat, glm::radians(angle), glm::normalize(toGlm(rotation)));
+                auto meshId = up.get<MeshId>();
+                if (meshId && meshId->id != NullKey) {
+                    std::get<eMeshModels>(manager.mesh.states.at(meshId->id)).get().insert(
+                            up.id());
                 }
-                mat = glm::scale(mat, toGlm(scale));
+                models.transformTargets.emplace_back(up.get<ModelId>()->id,
+                        meshId ? meshId->id : NullKey);
+            }
+        }
+
+        // модели в списке изменений не повторяются, поэтому задачи пишут в разные строки
+        models.transforms.resize(batch.size());
+        auto transforms = models.transforms.data();
+        app.id->jobs.parallelFor(0, batch.size(), transformGrain, [&](size_t begin, size_t end) {
+            composeTransforms(batch, begin, end, transforms);
+
+            for (size_t i = begin; i != end; ++i) {
+                auto[modelKey, meshKey] = models.transformTargets[i];
+                auto &&row = models.states.at(modelKey);
+                auto &model = std::get<eModelState>(row).get();
+                auto &bounds = std::get<eModelBounds>(row).get();
 
-                updateUniformBuffer(app.id->core.renderer.get(), model.uniform,
-                        scenePipeline::PerObject{mat});
+                model.transform = transforms[i];
+                bounds = {};
+                if (meshKey != NullKey) {
+                    auto const &mesh = std::get<eMeshState>(
+                            manager.mesh.states.at(meshKey)).get();
+                    bounds = transformAabb(mesh.bounds, model.transform);
+                }
             }
+        });
+    }
+
+    void cullModels(flecs::entity, ApplicationId app) {
+        auto &manager = app.id->manager;
+        auto &models = manager.model;
+        auto states = models.states.column<eModelState>();
+        auto bounds = models.states.column<eModelBounds>();
+        auto visible = models.states.column<eModelVisible>();
+        auto &batch = models.cullBatch;
+        auto &jobs = app.id->jobs;
+
+        batch.resize(bounds.size());
+        jobs.parallelFor(0, bounds.size(), cullGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i != end; ++i) {
+                batch.set(i, bounds[i]);
+            }
+        });
+
+        // viewport обычно один, поэтому боксы проверяются целиком для каждого viewport,
+        // а не группируются по нему. Соседние модели почти всегда в одном viewport, так что
+        // поиск в списке нужен только при смене ключа
+        auto &viewports = models.cullViewports;
+        viewports.clear();
+        Key previous = NullKey;
+        for (auto const &model : states) {
+            auto key = model.resources[0];
+            if (key == previous || key == NullKey) {
+                continue;
+            }
+            previous = key;
+            if (std::find(viewports.begin(), viewports.end(), key) == viewports.end() &&
+                    manager.viewport.states.contains(key)) {
+                viewports.push_back(key);
+            }
+        }
+
+        for (auto key : viewports) {
+            auto const &frustum = std::get<eViewportState>(
+                    manager.viewport.states.at(key)).get().frustum;
+            jobs.parallelFor(0, bounds.size(), cullGrain, [&](size_t begin, size_t end) {
+                batch.cull(frustum, begin, end);
+                for (size_t i = begin; i != end; ++i) {
+                    if (states[i].resources[0] == key) {
+                        visible[i] = batch.visible[i];
+                    }
+                }
+            });
         }
     }
 
     void catchUpdateTransform(flecs::entity e, ApplicationRef ref) {
-        ref.ref->id->manager.model.toUpdateTransform.push_back(e.id());
+        ref.ref->id->manager.model.toUpdateTransform.push(mainWorldEntity(ref, e));
     }
 
     void regModelToViewport(flecs::entity e, ApplicationRef app, ViewportRef viewport) {
@@ -197,7 +282,7 @@ namespace rise::rendering {
                 "Model, TRAIT | Initialized > ModelId,"
                 "[in] ANY:rise.rendering.Position3D,"
                 "[in] ANY:rise.rendering.Scale3D,"
-                "[in] ANY:rise.rendering.Rotation3D").
+                "[in] ANY:rise.rendering.Orientation3D").
                 kind(flecs::OnSet).each(catchUpdateTransform);
 
         ecs.system<const ApplicationRef, const ViewportRef>("regModelToViewport",
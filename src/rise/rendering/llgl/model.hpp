@@ -8,5 +8,11 @@ namespace rise::rendering {
 
     void recreateDescriptors(flecs::entity, ApplicationId app);
 
+    // снимает ссылку модели на общий набор дескрипторов, последняя ссылка освобождает его
+    void releaseModelHeap(ApplicationState &app, ModelState &model);
+
     void updateTransform(flecs::entity, ApplicationId app);
+
+    // пакетный отбор мировых AABB всех моделей по frustum их viewport до записи отрисовок
+    void cullModels(flecs::entity, ApplicationId app);
 }
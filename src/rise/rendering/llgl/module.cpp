@@ -9,6 +9,8 @@
 #include "texture.hpp"
 #include "viewport.hpp"
 #include "shadows.hpp"
+#include <thread>
+#include <algorithm>
 
 namespace rise::rendering {
     template<typename T>
@@ -62,9 +64,11 @@ namespace rise::rendering {
                     auto title = getOrInit(e, Title{"Minecraft 2"});
                     auto path = getOrInit(e, Path{"./rendering"});
                     auto extent = getOrInit(e, Extent2D{1600, 1000});
+                    auto threads = getOrInit(e, Threads{
+                            std::max(2u, std::thread::hardware_concurrency())});
                     e.set<Relative>({false});
 
-                    auto application = new ApplicationState;
+                    auto application = new ApplicationState(std::max(1u, threads->count) - 1);
                     initPlatformWindow(e, *application, *title, *extent);
                     initCoreRenderer(e, *application);
                     initPlatformSurface(e, *application);
@@ -72,6 +76,7 @@ namespace rise::rendering {
                     initGuiState(e, *application, *path);
                     initSceneState(e, *application, *path);
                     initShadowsState(e, *application, *path);
+                    e.set<JobSystemId>({&application->jobs});
                     e.set<ApplicationId>({application});
                     e.set<ApplicationRef>({e.get_ref<ApplicationId>()});
                 });
@@ -95,6 +100,7 @@ namespace rise::rendering {
 
         ecs.system<>("removeApplication", "Application").kind(flecs::OnRemove).each(
                 [](flecs::entity e) {
+                    e.remove<JobSystemId>();
                     delete e.get<ApplicationId>();
                     e.remove<ApplicationId>();
                 });
@@ -112,12 +118,33 @@ namespace rise::rendering {
 
         // On load --------------------------------------------------------------------------------
 
-        ecs.system<const ApplicationId, Extent2D>("pullInputEvents", "Application").
-                kind(flecs::OnLoad).each(pullInputEvents);
+        mainThreadSystem(ecs, flecs::OnLoad,
+                ecs.system<const ApplicationId, Extent2D>("pullInputEvents", "Application"),
+                pullInputEvents);
 
         // Pre store ------------------------------------------------------------------------------
 
-        ecs.system<const ApplicationId>("prepareResourcesRemove").kind(flecs::PreStore).each(
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("reloadChangedFiles"),
+                [](flecs::entity e, ApplicationId app) {
+                    std::vector<std::string> changed;
+                    if (!app.id->core.watcher.poll(changed)) {
+                        return;
+                    }
+
+                    auto ecs = e.world();
+                    reloadTextures(*app.id, changed);
+                    reloadMeshes(*app.id, changed);
+                    reloadSceneShaders(*app.id, changed);
+                    reloadShadowShaders(ecs, *app.id, changed);
+                    reloadGuiShaders(*app.id, changed);
+                });
+
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("pollTextures"), pollTextures);
+
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("prepareResourcesRemove"),
                 [](flecs::entity e, ApplicationId app) {
                     auto &manager = app.id->manager;
                     prepareRemove<eTextureModels>(manager, manager.texture);
@@ -125,165 +152,184 @@ namespace rise::rendering {
                     prepareRemove<eViewportModels>(manager, manager.viewport);
                 });
 
-        ecs.system<const ApplicationId>("clearDescriptors").kind(flecs::PreStore).each(
-                clearDescriptors);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("prepareMeshUpdate"), prepareMeshUpdate);
+
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("clearDescriptors"), clearDescriptors);
 
-        ecs.system<const ApplicationId>("processResourcesRemove").kind(flecs::PreStore).each(
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("processResourcesRemove"),
                 [](flecs::entity e, ApplicationId app) {
                     auto &manager = app.id->manager;
-                    auto renderer = app.id->core.renderer.get();
-                    auto queue = app.id->core.queue;
+                    auto &releases = app.id->core.releases;
+                    auto frame = app.id->core.frame;
 
+                    // общие текстуры и меши освобождаются вместе с последней ссылкой
                     processRemoveInit<eTextureState>(manager, manager.texture,
-                            [renderer, queue](TextureState &state) {
-                                if (state.val != nullptr) {
-                                    queue->WaitIdle();
-                                    renderer->Release(*state.val);
-                                    state.val = nullptr;
+                            [&releases, &manager, frame](TextureState &state) {
+                                if (manager.texture.registry.release(state.val)) {
+                                    releases.push(state.val, frame);
                                 }
+                                state.val = nullptr;
                             });
                     processRemoveInit<eMeshState>(manager, manager.mesh,
-                            [renderer, queue](MeshState &state) {
-                                if (state.vertices != nullptr) {
-                                    queue->WaitIdle();
-                                    renderer->Release(*state.vertices);
-                                    renderer->Release(*state.indices);
-                                    state.vertices = nullptr;
-                                    state.indices = nullptr;
+                            [&releases, &manager, frame](MeshState &state) {
+                                if (manager.mesh.registry.release(state.vertices)) {
+                                    releases.push(state.instanced, frame);
+                                    releases.push(state.shadowInstanced, frame);
+                                    releases.push(state.vertices, frame);
+                                    releases.push(state.attributes, frame);
+                                    releases.push(state.indices, frame);
                                 }
+                                state.instanced = nullptr;
+                                state.shadowInstanced = nullptr;
+                                state.vertices = nullptr;
+                                state.attributes = nullptr;
+                                state.indices = nullptr;
                             });
                     processRemoveInit<eMaterialState>(manager, manager.material,
-                            [renderer, queue](MaterialState &state) {
-                                if (state.uniform != nullptr) {
-                                    queue->WaitIdle();
-                                    renderer->Release(*state.uniform);
-                                    state.uniform = nullptr;
-                                }
+                            [&releases, frame](MaterialState &state) {
+                                releases.push(state.uniform, frame);
+                                state.uniform = nullptr;
                             });
                     processRemoveInit<eViewportState>(manager, manager.viewport,
-                            [renderer, queue](ViewportState &state) {
-                                queue->WaitIdle();
-                                renderer->Release(*state.cubeMaps);
+                            [&releases, frame](ViewportState &state) {
+                                releases.push(state.cubeMaps, frame);
                                 for (size_t i = 0; i != scenePipeline::maxLightCount; ++i) {
-                                    renderer->Release(*state.cubeTarget[i].target);
-                                    renderer->Release(*state.cubeTarget[i].pipeline);
+                                    releases.push(state.cubeTarget[i].target, frame);
+                                    releases.push(state.cubeTarget[i].pipeline, frame);
                                     state.cubeTarget[i].target = nullptr;
                                     state.cubeTarget[i].pipeline = nullptr;
                                 }
 
-                                renderer->Release(*state.uniform);
+                                releases.push(state.uniform, frame);
+                                state.cubeMaps = nullptr;
                                 state.uniform = nullptr;
                             });
                     processRemoveInit<eModelState>(manager, manager.model,
-                            [renderer, queue](ModelState &state) {
-                                queue->WaitIdle();
-
-                                renderer->Release(*state.uniform);
-                                renderer->Release(*state.heap);
-                                state.uniform = nullptr;
-                                state.heap = nullptr;
+                            [&app](ModelState &state) {
+                                releaseModelHeap(*app.id, state);
                             });
                     processRemoveInit<eLightState>(manager, manager.light,
-                            [renderer, queue](LightState &state) {
-                                queue->WaitIdle();
-                                if(state.parameters != nullptr) {
-                                    renderer->Release(*state.parameters);
-                                    renderer->Release(*state.matrices);
-                                    state.parameters = nullptr;
-                                    state.matrices = nullptr;
-                                }
+                            [&releases, frame](LightState &state) {
+                                releases.push(state.heap, frame);
+                                releases.push(state.parameters, frame);
+                                releases.push(state.matrices, frame);
+                                state.heap = nullptr;
+                                state.parameters = nullptr;
+                                state.matrices = nullptr;
                             });
                 });
 
-        ecs.system<const ApplicationId>("initShadowModels").kind(flecs::PreStore).
-                each(initShadowModels);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("recreateDescriptors"), recreateDescriptors);
+
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("updateMaterial"), updateMaterial);
 
-        ecs.system<const ApplicationId>("removeShadowModels").kind(flecs::PreStore).
-                each(removeShadowModels);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("updateLightUniforms"), updateLightUniforms);
 
-        ecs.system<const ApplicationId>("recreateDescriptors").kind(flecs::PreStore).each(
-                recreateDescriptors);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("updateTransform"), updateTransform);
 
-        ecs.system<const ApplicationId>("updateMaterial").kind(flecs::PreStore).each(
-                updateMaterial);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationRef, const ViewportId>("prepareViewport",
+                "TRAIT | Initialized > ViewportId"), prepareViewport);
 
-        ecs.system<const ApplicationId>("updateLightUniforms").kind(flecs::PreStore).each(
-                updateLightUniforms);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationRef, const ViewportId, const Extent2D, const Position3D,
+                const Rotation3D>("updateViewportCamera", "TRAIT | Initialized > ViewportId"),
+                updateViewportCamera);
 
-        ecs.system<const ApplicationId>("updateTransform").kind(flecs::PreStore).each(
-                updateTransform);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationRef, const ViewportRef, const Position3D,
+                const DiffuseColor, const Intensity, const Distance, LightId>("updateViewportLight",
+                "PointLight"), updateViewportLight);
 
-        ecs.system<const ApplicationRef, const ViewportId>("prepareViewport",
-                "TRAIT | Initialized > ViewportId").
-                kind(flecs::PreStore).each(prepareViewport);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationRef, const ViewportId>("finishViewport",
+                "TRAIT | Initialized > ViewportId"), finishViewport);
 
-        ecs.system<const ApplicationRef, const ViewportId, const Extent2D, const Position3D,
-                const Rotation3D>("updateViewportCamera", "TRAIT | Initialized > ViewportId").
-                kind(flecs::PreStore).each(updateViewportCamera);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("cullModels"), cullModels);
 
-        ecs.system<const ApplicationRef, const ViewportRef, const Position3D, const DiffuseColor,
-                const Intensity, const Distance, LightId>("updateViewportLight", "PointLight").
-                kind(flecs::PreStore).each(updateViewportLight);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("prepareRender", "Application"), prepareRender);
 
-        ecs.system<const ApplicationRef, const ViewportId>("finishViewport",
-                "TRAIT | Initialized > ViewportId").
-                kind(flecs::PreStore).each(finishViewport);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationRef, const ViewportRef,
+                const LightId>("updateShadowMaps", "PointLight"), updateShadowMaps);
 
-        ecs.system<const ApplicationId>("prepareRender", "Application").kind(flecs::PreStore).
-                each(prepareRender);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("colorPass", "Application"), prepareColorPass);
 
-        ecs.system<const ApplicationRef, const ViewportRef, const LightId>("updateShadowMaps",
-                "PointLight").kind(flecs::PreStore).each(updateShadowMaps);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationRef, const ViewportRef, const MeshId,
+                const ModelId>("renderScene",
+                "ANY: TRAIT | Initialized > MeshId," "ANY: TRAIT | Initialized > ModelId"),
+                renderScene);
 
-        ecs.system<const ApplicationId>("colorPass", "Application").kind(flecs::PreStore).
-                each(prepareColorPass);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId>("flushSceneQueue", "Application"), flushSceneQueue);
 
-        ecs.system<const ApplicationRef, const ViewportRef, const MeshId, const ModelId>(
-                "renderScene",
-                "ANY: TRAIT | Initialized > MeshId," "ANY: TRAIT | Initialized > ModelId"
-        ).kind(flecs::PreStore).each(renderScene);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId, const GuiContext>("prepareImgui", "Application"),
+                prepareImgui);
 
-        ecs.system<const ApplicationId, const GuiContext>("prepareImgui", "Application").
-                kind(flecs::PreStore).each(prepareImgui);
+        mainThreadSystem(ecs, flecs::PreStore,
+                ecs.system<const ApplicationId, const GuiContext>("drawStatistics",
+                "Application"), drawStatistics);
 
         // On store -------------------------------------------------------------------------------
 
-        ecs.system<const GuiContext>("processImGui", "Application").kind(flecs::OnStore).each(
-                processImGui);
+        mainThreadSystem(ecs, flecs::OnStore,
+                ecs.system<const GuiContext>("processImGui", "Application"), processImGui);
 
-        ecs.system<const ApplicationId, const GuiContext>("updateGuiResources", "Application").
-                kind(flecs::OnStore).each(updateResources);
+        mainThreadSystem(ecs, flecs::OnStore,
+                ecs.system<const ApplicationId, const GuiContext>("updateGuiResources",
+                "Application"), updateResources);
 
-        ecs.system<const ApplicationId, const GuiContext, const Extent2D>("renderGui",
-                "OWNED:Application").kind(flecs::OnStore).each(renderGui);
+        mainThreadSystem(ecs, flecs::OnStore,
+                ecs.system<const ApplicationId, const GuiContext, const Extent2D>("renderGui",
+                "OWNED:Application"), renderGui);
 
-        ecs.system<const ApplicationId>("endColorPass", "Application").kind(flecs::OnStore).
-                each(endColorPass);
+        mainThreadSystem(ecs, flecs::OnStore,
+                ecs.system<const ApplicationId>("endColorPass", "Application"), endColorPass);
 
-        ecs.system<const ApplicationId>("submitRender", "Application").kind(flecs::OnStore).
-                each(submitRender);
+        mainThreadSystem(ecs, flecs::OnStore,
+                ecs.system<const ApplicationId>("submitRender", "Application"), submitRender);
 
-        ecs.system<const ApplicationId>("clearCommands").kind(flecs::OnStore).each(
+        mainThreadSystem(ecs, flecs::OnStore,
+                ecs.system<const ApplicationId>("clearCommands"),
                 [](flecs::entity e, ApplicationId app) {
                     auto &manager = app.id->manager;
-                    manager.texture.toInit.clear();
-                    manager.texture.toRemove.clear();
-                    manager.viewport.toInit.clear();
-                    manager.viewport.toRemove.clear();
-                    manager.light.toInitShadowModels.clear();
-                    manager.light.toRemoveShadowModels.clear();
-                    manager.light.toInit.clear();
+                    app.id->core.releases.resetStats();
+                    manager.changes = manager.model.toUpdateTransform.stats();
+                    manager.changes += manager.material.toUpdate.stats();
+                    manager.changes += manager.light.toUpdate.stats();
+                    release(manager.texture.toInit);
+                    release(manager.texture.toRemove);
+                    release(manager.viewport.toInit);
+                    release(manager.viewport.toRemove);
+                    release(manager.light.toInit);
                     manager.light.toUpdate.clear();
-                    manager.light.toRemove.clear();
-                    manager.mesh.toInit.clear();
-                    manager.mesh.toRemove.clear();
-                    manager.model.toInit.clear();
-                    manager.model.toUpdateDescriptors.clear();
+                    release(manager.light.toRemove);
+                    release(manager.mesh.toInit);
+                    release(manager.mesh.toRemove);
+                    release(manager.model.toInit);
+                    release(manager.model.toUpdateDescriptors);
+                    manager.model.dirtyDescriptors.clear();
+                    release(manager.model.descriptorsToRebuild);
                     manager.model.toUpdateTransform.clear();
-                    manager.model.toRemove.clear();
-                    manager.material.toRemove.clear();
+                    release(manager.model.toRemove);
+                    release(manager.material.toRemove);
                     manager.material.toUpdate.clear();
-                    manager.material.toInit.clear();
+                    release(manager.material.toInit);
+                    // буферы всех очередей уже отданы, арену можно сбросить целиком
+                    manager.allocations = manager.frame.stats();
+                    manager.frame.reset();
                 });
     }
 }
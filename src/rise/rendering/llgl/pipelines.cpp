@@ -13,11 +13,6 @@ namespace rise::rendering::scenePipeline {
                 LLGL::BindFlags::ConstantBuffer,
                 LLGL::StageFlags::VertexStage | LLGL::StageFlags::FragmentStage,
                 1,
-        }, LLGL::BindingDescriptor{ // draw
-                LLGL::ResourceType::Buffer,
-                LLGL::BindFlags::ConstantBuffer,
-                LLGL::StageFlags::VertexStage | LLGL::StageFlags::FragmentStage,
-                2,
         }, LLGL::BindingDescriptor{
                 LLGL::ResourceType::Sampler,
                 0,
@@ -28,7 +23,7 @@ namespace rise::rendering::scenePipeline {
                 LLGL::BindFlags::Sampled,
                 LLGL::StageFlags::FragmentStage,
                 4,
-        }, LLGL::BindingDescriptor{
+        }, LLGL::BindingDescriptor{ // occlusion, roughness, metallic
                 LLGL::ResourceType::Texture,
                 LLGL::BindFlags::Sampled,
                 LLGL::StageFlags::FragmentStage,
@@ -38,21 +33,11 @@ namespace rise::rendering::scenePipeline {
                 LLGL::BindFlags::Sampled,
                 LLGL::StageFlags::FragmentStage,
                 6,
-        }, LLGL::BindingDescriptor{
-                LLGL::ResourceType::Texture,
-                LLGL::BindFlags::Sampled,
-                LLGL::StageFlags::FragmentStage,
-                7,
-        }, LLGL::BindingDescriptor{
-                LLGL::ResourceType::Texture,
-                LLGL::BindFlags::Sampled,
-                LLGL::StageFlags::FragmentStage,
-                8,
         }, LLGL::BindingDescriptor{
                 LLGL::ResourceType::Sampler,
                 0,
                 LLGL::StageFlags::FragmentStage,
-                9
+                7
         }};
 
         return renderer->CreatePipelineLayout(layoutDesc);
@@ -125,11 +110,6 @@ namespace rise::rendering::shadowPipeline {
     LLGL::PipelineLayout *createLayout(LLGL::RenderSystem *renderer) {
         LLGL::PipelineLayoutDescriptor layoutDesc;
         layoutDesc.bindings = {LLGL::BindingDescriptor{
-                LLGL::ResourceType::Buffer,
-                LLGL::BindFlags::ConstantBuffer,
-                LLGL::StageFlags::VertexStage,
-                0,
-        }, LLGL::BindingDescriptor{
                 LLGL::ResourceType::Buffer,
                 LLGL::BindFlags::ConstantBuffer,
                 LLGL::StageFlags::GeometryStage,
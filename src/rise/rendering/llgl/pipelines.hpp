@@ -4,7 +4,6 @@
 
 #include <LLGL/LLGL.h>
 #include <glm/glm.hpp>
-#include <glm/gtx/hash.hpp>
 
 namespace rise::rendering::scenePipeline {
     const float farPlane = 300.0f;
@@ -16,15 +15,13 @@ namespace rise::rendering::scenePipeline {
         glm::vec2 texCoord{};
     };
 
-    inline bool operator==(const Vertex &lhs, const Vertex &rhs) {
-        return lhs.pos == rhs.pos &&
-                lhs.normal == rhs.normal &&
-                lhs.texCoord == rhs.texCoord;
-    }
-
-    inline bool operator!=(const Vertex &lhs, const Vertex &rhs) {
-        return !(rhs == lhs);
-    }
+    // упакованные атрибуты вершины во втором потоке, позиции идут отдельным потоком float3:
+    // нормаль в октаэдрической проекции, текстурные координаты в half, цвет в RGBA8
+    struct PackedVertex {
+        int16_t normal[2];
+        uint16_t texCoord[2];
+        uint8_t color[4];
+    };
 
     struct PointLight {
         alignas(16) glm::vec3 position = {};
@@ -54,6 +51,10 @@ namespace rise::rendering::scenePipeline {
         alignas(16) glm::mat4 transform = {};
     };
 
+    // трансформации объектов на один кадр; буфер хранит по области на каждый кадр в полёте
+    static const uint32_t maxInstances = 16384;
+    static const uint32_t framesInFlight = 3;
+
     LLGL::PipelineLayout *createLayout(LLGL::RenderSystem *renderer);
 
     LLGL::PipelineState *createPipeline(LLGL::RenderSystem *renderer,
@@ -96,14 +97,3 @@ namespace rise::rendering::shadowPipeline {
             LLGL::PipelineLayout *layout, LLGL::ShaderProgram *program,
             LLGL::RenderPass const *pass);
 }
-
-namespace std {
-    template<>
-    struct hash<rise::rendering::scenePipeline::Vertex> {
-        size_t operator()(rise::rendering::scenePipeline::Vertex const &vertex) const {
-            return ((hash<glm::vec3>()(vertex.pos) ^
-                    (hash<glm::vec3>()(vertex.normal) << 1)) >> 1) ^
-                    (hash<glm::vec2>()(vertex.texCoord) << 1);
-        }
-    };
-}
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
+#include "util/soa.hpp"
+
+namespace rise::rendering {
+    struct RegistryStats {
+        size_t resources = 0;
+        size_t references = 0;
+        // сколько байт видеопамяти заняли бы копии ресурсов, используемых несколькими
+        // состояниями
+        size_t bytesDeduplicated = 0;
+        // запросы, получившие уже загруженный или загружающийся путь без новой загрузки
+        size_t pathHits = 0;
+        // загрузки, содержимое которых совпало с уже загруженным ресурсом
+        size_t contentHits = 0;
+    };
+
+    // общие GPU ресурсы по нормализованному пути и хэшу содержимого. Состояния разных сущностей
+    // с одинаковым источником получают одно значение, ссылки считаются по identity -
+    // указателю на GPU объект, ресурс освобождается вместе с последней ссылкой
+    template<typename T>
+    class ResourceRegistry {
+    public:
+        struct Entry {
+            T value{};
+            void const *identity = nullptr;
+            bool ready = false;
+            uint32_t refs = 0;
+            uint64_t hash = 0;
+            size_t bytes = 0;
+            std::vector<Key> waiting;
+            std::vector<Key> users;
+            std::vector<std::string> paths;
+            // ресурс до перезагрузки, к нему возвращаются при её ошибке
+            std::weak_ptr<Entry> previous;
+            // файл изменился ещё раз, пока шла загрузка: её результат уже устарел
+            bool dirty = false;
+        };
+
+        // привязывает user к ресурсу path; true - ресурс запрошен впервые и его нужно
+        // загрузить, иначе готовый ресурс возвращается через entry, а незагруженный ждёт
+        bool request(std::string const &path, Key user, Entry const *&entry) {
+            auto pending = mWaiting.find(user);
+            if (pending != mWaiting.end() && pending->second == path) {
+                entry = mPaths.at(path).get();
+                return false;
+            }
+            cancel(user);
+
+            auto it = mPaths.find(path);
+            if (it == mPaths.end()) {
+                auto added = std::make_shared<Entry>();
+                added->paths.push_back(path);
+                it = mPaths.emplace(path, added).first;
+            }
+
+            entry = it->second.get();
+            if (it->second->ready) {
+                it->second->users.push_back(user);
+                mHolding[user] = path;
+                ++mStats.pathHits;
+                return false;
+            }
+
+            bool first = it->second->waiting.empty();
+            it->second->waiting.push_back(user);
+            mWaiting[user] = path;
+            if (!first) {
+                ++mStats.pathHits;
+            }
+            return first;
+        }
+
+        // отменяет ожидание, если сущность удалена или сменила путь до окончания загрузки
+        void cancel(Key user) {
+            auto it = mWaiting.find(user);
+            if (it != mWaiting.end()) {
+                auto entry = mPaths.find(it->second);
+                if (entry != mPaths.end()) {
+                    erase(entry->second->waiting, user);
+                }
+                mWaiting.erase(it);
+            }
+
+            it = mHolding.find(user);
+            if (it != mHolding.end()) {
+                auto entry = mPaths.find(it->second);
+                if (entry != mPaths.end()) {
+                    erase(entry->second->users, user);
+                }
+                mHolding.erase(it);
+            }
+        }
+
+        // файл path изменился: его пользователи снова ждут загрузки, а прежний ресурс
+        // остаётся у них до её окончания. false - путь никем не используется или уже
+        // загружается, тогда он попадёт в takeDirty() после окончания загрузки
+        bool reload(std::string const &path) {
+            auto it = mPaths.find(path);
+            if (it == mPaths.end()) {
+                return false;
+            }
+            if (!it->second->ready) {
+                it->second->dirty = true;
+                return false;
+            }
+
+            auto previous = it->second;
+            auto fresh = std::make_shared<Entry>();
+            fresh->paths.push_back(path);
+            fresh->previous = previous;
+            for (auto user : previous->users) {
+                auto holding = mHolding.find(user);
+                if (holding != mHolding.end() && holding->second == path) {
+                    fresh->waiting.push_back(user);
+                    mWaiting[user] = path;
+                    mHolding.erase(holding);
+                }
+            }
+
+            if (fresh->waiting.empty()) {
+                return false;
+            }
+
+            for (auto user : fresh->waiting) {
+                erase(previous->users, user);
+            }
+            previous->paths.erase(std::remove(previous->paths.begin(), previous->paths.end(),
+                    path), previous->paths.end());
+            it->second = fresh;
+            return true;
+        }
+
+        // ожидающие загрузки path; пустой список - результат больше никому не нужен
+        std::vector<Key> const *waiting(std::string const &path) const {
+            auto it = mPaths.find(path);
+            if (it == mPaths.end() || it->second->ready || it->second->waiting.empty()) {
+                return nullptr;
+            }
+            return &it->second->waiting;
+        }
+
+        // уже загруженный ресурс с тем же содержимым
+        Entry const *findHash(uint64_t hash) const {
+            auto it = mHashes.find(hash);
+            return it == mHashes.end() ? nullptr : it->second.get();
+        }
+
+        // завершает загрузку path; если identity уже известен (совпал хэш содержимого), path
+        // становится псевдонимом существующего ресурса. Возвращает ожидавших пользователей
+        std::vector<Key> complete(std::string const &path, T const &value,
+                void const *identity, uint64_t hash, size_t bytes) {
+            auto it = mPaths.find(path);
+            if (it == mPaths.end()) {
+                return {};
+            }
+
+            auto entry = it->second;
+            auto users = std::move(entry->waiting);
+            entry->waiting.clear();
+            if (entry->dirty) {
+                entry->dirty = false;
+                mDirty.push_back(path);
+            }
+            for (auto user : users) {
+                mWaiting.erase(user);
+                mHolding[user] = path;
+            }
+
+            auto known = mIdentities.find(identity);
+            if (known != mIdentities.end()) {
+                auto &shared = known->second;
+                if (std::find(shared->paths.begin(), shared->paths.end(), path) ==
+                        shared->paths.end()) {
+                    shared->paths.push_back(path);
+                }
+                shared->users.insert(shared->users.end(), users.begin(), users.end());
+                it->second = shared;
+                ++mStats.contentHits;
+                return users;
+            }
+
+            entry->users = users;
+
+            entry->value = value;
+            entry->identity = identity;
+            entry->ready = true;
+            entry->hash = hash;
+            entry->bytes = bytes;
+            mIdentities[identity] = entry;
+            mHashes[hash] = entry;
+            ++mStats.resources;
+            return users;
+        }
+
+        // загрузка не удалась: следующий запрос попробует снова, а при перезагрузке
+        // пользователи остаются с прежним ресурсом
+        void fail(std::string const &path) {
+            auto it = mPaths.find(path);
+            if (it == mPaths.end() || it->second->ready) {
+                return;
+            }
+
+            auto failed = it->second;
+            auto previous = failed->previous.lock();
+            if (failed->dirty) {
+                mDirty.push_back(path);
+            }
+            for (auto user : failed->waiting) {
+                mWaiting.erase(user);
+                if (previous) {
+                    mHolding[user] = path;
+                    previous->users.push_back(user);
+                }
+            }
+
+            if (previous && previous->ready) {
+                previous->paths.push_back(path);
+                it->second = previous;
+            } else {
+                mPaths.erase(it);
+            }
+        }
+
+        // состояние получило значение ресурса
+        void retain(void const *identity) {
+            auto it = mIdentities.find(identity);
+            if (it == mIdentities.end()) {
+                return;
+            }
+
+            if (it->second->refs++ != 0) {
+                mStats.bytesDeduplicated += it->second->bytes;
+            }
+            ++mStats.references;
+        }
+
+        // состояние перестало использовать ресурс; true - ссылок не осталось и GPU объекты
+        // нужно освободить
+        bool release(void const *identity) {
+            auto it = mIdentities.find(identity);
+            if (it == mIdentities.end()) {
+                return false;
+            }
+
+            auto entry = it->second;
+            --mStats.references;
+            if (--entry->refs != 0) {
+                mStats.bytesDeduplicated -= entry->bytes;
+                return false;
+            }
+
+            for (auto const &path : entry->paths) {
+                auto p = mPaths.find(path);
+                if (p != mPaths.end() && p->second == entry) {
+                    mPaths.erase(p);
+                }
+            }
+            auto hash = mHashes.find(entry->hash);
+            if (hash != mHashes.end() && hash->second == entry) {
+                mHashes.erase(hash);
+            }
+            mIdentities.erase(it);
+            --mStats.resources;
+            return true;
+        }
+
+        // пути, изменившиеся во время своей загрузки; их нужно перезагрузить ещё раз
+        std::vector<std::string> takeDirty() {
+            std::vector<std::string> dirty;
+            dirty.swap(mDirty);
+            return dirty;
+        }
+
+        RegistryStats const &stats() const {
+            return mStats;
+        }
+
+    private:
+        static void erase(std::vector<Key> &users, Key user) {
+            users.erase(std::remove(users.begin(), users.end(), user), users.end());
+        }
+
+        std::unordered_map<std::string, std::shared_ptr<Entry>> mPaths;
+        std::unordered_map<uint64_t, std::shared_ptr<Entry>> mHashes;
+        std::unordered_map<void const *, std::shared_ptr<Entry>> mIdentities;
+        std::map<Key, std::string> mWaiting;
+        std::map<Key, std::string> mHolding;
+        std::vector<std::string> mDirty;
+        RegistryStats mStats;
+    };
+}
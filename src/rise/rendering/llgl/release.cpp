@@ -0,0 +1,52 @@
+#include "release.hpp"
+#include <algorithm>
+
+namespace rise::rendering {
+    void FrameFences::init(LLGL::RenderSystem *renderer, uint32_t framesInFlight) {
+        for (uint32_t i = 0; i != framesInFlight; ++i) {
+            mFences.push_back(renderer->CreateFence());
+        }
+        mFrames.assign(framesInFlight, 0);
+    }
+
+    void FrameFences::wait(LLGL::CommandQueue *queue, uint64_t frame) {
+        auto slot = frame % mFences.size();
+        if (mFrames[slot] != 0) {
+            queue->WaitFence(*mFences[slot], ~0ull);
+            mCompleted = std::max(mCompleted, mFrames[slot]);
+            mFrames[slot] = 0;
+        }
+    }
+
+    void FrameFences::submit(LLGL::CommandQueue *queue, LLGL::CommandBuffer &cmdBuf,
+            uint64_t frame) {
+        auto slot = frame % mFences.size();
+        queue->Submit(cmdBuf);
+        queue->Submit(*mFences[slot]);
+        mFrames[slot] = frame;
+        mSubmitted = frame;
+    }
+
+    uint64_t FrameFences::completed(LLGL::CommandQueue *queue) {
+        // fence сигналят в порядке отправки, поэтому опрос останавливается на первом
+        // незавершённом кадре
+        for (uint64_t frame = mCompleted + 1; frame <= mSubmitted; ++frame) {
+            auto slot = frame % mFences.size();
+            if (mFrames[slot] != frame || !queue->QueryFence(*mFences[slot])) {
+                break;
+            }
+            mCompleted = frame;
+            mFrames[slot] = 0;
+        }
+        return mCompleted;
+    }
+
+    void ReleaseQueue::retire(LLGL::RenderSystem *renderer, uint64_t completed) {
+        while (!mPending.empty() && mPending.front().frame <= completed) {
+            mPending.front().release(renderer);
+            mPending.pop_front();
+            ++mStats.retired;
+        }
+        mStats.pending = static_cast<uint32_t>(mPending.size());
+    }
+}
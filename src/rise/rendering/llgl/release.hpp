@@ -0,0 +1,77 @@
+#pragma once
+
+#include <LLGL/LLGL.h>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+namespace rise::rendering {
+    struct ReleaseStats {
+        uint32_t deferred = 0;
+        uint32_t retired = 0;
+        uint32_t pending = 0;
+    };
+
+    // fence на каждый кадр в полёте: по их сигналам известно, какие кадры GPU уже выполнил.
+    // Кадр с тем же слотом ждёт fence предыдущего владельца слота, так CPU не уходит вперёд
+    // больше чем на framesInFlight кадров
+    class FrameFences {
+    public:
+        void init(LLGL::RenderSystem *renderer, uint32_t framesInFlight);
+
+        // перед записью кадра frame
+        void wait(LLGL::CommandQueue *queue, uint64_t frame);
+
+        // отправляет команды кадра и fence за ними
+        void submit(LLGL::CommandQueue *queue, LLGL::CommandBuffer &cmdBuf, uint64_t frame);
+
+        // последний кадр, все команды которого GPU завершил; опрос без ожидания
+        uint64_t completed(LLGL::CommandQueue *queue);
+
+    private:
+        std::vector<LLGL::Fence *> mFences;
+        // кадр, после которого отправлен fence слота, 0 - fence свободен
+        std::vector<uint64_t> mFrames;
+        uint64_t mSubmitted = 0;
+        uint64_t mCompleted = 0;
+    };
+
+    // отложенное удаление ресурсов: объект освобождается только после того, как GPU завершил
+    // все кадры, которые могли его использовать, вместо queue->WaitIdle() на каждое удаление
+    class ReleaseQueue {
+    public:
+        // frame - последний кадр, команды которого могли ссылаться на объект
+        template<typename T>
+        void push(T *object, uint64_t frame) {
+            if (object) {
+                mPending.push_back({frame, [object](LLGL::RenderSystem *renderer) {
+                    renderer->Release(*object);
+                }});
+                ++mStats.deferred;
+                mStats.pending = static_cast<uint32_t>(mPending.size());
+            }
+        }
+
+        // освобождает объекты кадров до completed включительно, см. FrameFences::completed
+        void retire(LLGL::RenderSystem *renderer, uint64_t completed);
+
+        ReleaseStats const &stats() const {
+            return mStats;
+        }
+
+        void resetStats() {
+            mStats.deferred = 0;
+            mStats.retired = 0;
+        }
+
+    private:
+        struct Pending {
+            uint64_t frame;
+            std::function<void(LLGL::RenderSystem *)> release;
+        };
+
+        std::deque<Pending> mPending;
+        ReleaseStats mStats;
+    };
+}
@@ -3,10 +3,24 @@
 #include <SDL.h>
 #include <LLGL/LLGL.h>
 #include <flecs.h>
-#include <set>
+#include <map>
+#include <mutex>
 #include "../module.hpp"
+#include "../queue.hpp"
 #include "pipelines.hpp"
+#include "culling.hpp"
+#include "geometry.hpp"
+#include "ring.hpp"
+#include "release.hpp"
+#include "loader.hpp"
+#include "registry.hpp"
+#include "watcher.hpp"
+#include "dirty.hpp"
+#include "transform.hpp"
 #include "util/soa.hpp"
+#include "util/flat_set.hpp"
+#include "util/jobs.hpp"
+#include "util/arena.hpp"
 
 namespace rise::rendering {
     struct Previous {
@@ -35,9 +49,13 @@ namespace rise::rendering {
 
     struct MeshState {
         LLGL::Buffer *vertices = nullptr;
+        LLGL::Buffer *attributes = nullptr;
         LLGL::Buffer *indices = nullptr;
+        LLGL::BufferArray *instanced = nullptr;
+        LLGL::BufferArray *shadowInstanced = nullptr;
         unsigned numIndices = 0;
         unsigned numVertices = 0;
+        Aabb bounds;
     };
 
     struct MaterialId {
@@ -52,9 +70,13 @@ namespace rise::rendering {
         Key id = NullKey;
     };
 
+    // viewport, material и текстуры, из которых собран набор дескрипторов модели
+    using ModelResourceKeys = std::array<Key, 4>;
+
     struct ModelState {
-        LLGL::Buffer *uniform = nullptr;
         LLGL::ResourceHeap *heap = nullptr;
+        glm::mat4 transform = glm::mat4(1);
+        ModelResourceKeys resources{};
     };
 
     struct ViewportId {
@@ -75,7 +97,7 @@ namespace rise::rendering {
         scenePipeline::PerViewport *pData = nullptr;
         LLGL::Texture *cubeMaps = nullptr;
         std::array<ShadowTarget, scenePipeline::maxLightCount> cubeTarget{};
-
+        Frustum frustum{};
     };
 
     struct UpdatedViewportState {
@@ -92,22 +114,27 @@ namespace rise::rendering {
     struct LightState {
         LLGL::Buffer *matrices = nullptr;
         LLGL::Buffer *parameters = nullptr;
+        LLGL::ResourceHeap *heap = nullptr;
         size_t id = 0;
+        glm::vec3 position{};
+        float distance = 0;
     };
 
     struct LightId {
         Key id = NullKey;
     };
 
-    struct ShadowModel {
-        LLGL::ResourceHeap *heap = nullptr;
-    };
-
     struct CoreState {
         std::unique_ptr<LLGL::RenderSystem> renderer = nullptr;
         LLGL::CommandQueue *queue = nullptr;
         LLGL::CommandBuffer *cmdBuf = nullptr;
         LLGL::Sampler *sampler = nullptr;
+        uint64_t frame = 0;
+        // последний кадр, выполненный GPU, обновляется в prepareRender
+        uint64_t completedFrame = 0;
+        FrameFences fences;
+        ReleaseQueue releases;
+        FileWatcher watcher;
     };
 
     struct Platform {
@@ -115,29 +142,64 @@ namespace rise::rendering {
         LLGL::RenderContext *context = nullptr;
     };
 
+    struct ScenePacket {
+        LLGL::ResourceHeap *heap = nullptr;
+        MeshId mesh;
+        LLGL::Viewport viewport;
+        scenePipeline::PerObject object;
+    };
+
+    struct CullingStats {
+        uint32_t visible = 0;
+        uint32_t culled = 0;
+        uint32_t shadowVisible = 0;
+        uint32_t shadowCulled = 0;
+    };
+
     struct SceneState {
         LLGL::PipelineLayout *layout = nullptr;
+        LLGL::ShaderProgram *program = nullptr;
         LLGL::PipelineState *pipeline = nullptr;
+        std::string shaders;
         LLGL::VertexFormat format;
+        LLGL::VertexFormat attributeFormat;
+        LLGL::VertexFormat instanceFormat;
+        FrameRing instances;
+        bool instancing = true;
+        // переупорядочивание треугольников и вершин при импорте мешей
+        bool optimizeMeshes = true;
+        RenderQueue<ScenePacket> queue;
+        HandleTable<LLGL::PipelineState *> pipelines;
+        HandleTable<ModelResourceKeys> heaps;
+        HandleTable<Key> meshes;
+        RenderQueueStats stats;
+        CullingStats culling;
     };
 
     struct ShadowState {
         LLGL::PipelineLayout *layout = nullptr;
         LLGL::ShaderProgram *program = nullptr;
+        std::string shaders;
         LLGL::VertexFormat format;
+        LLGL::VertexFormat instanceFormat;
         LLGL::RenderPass* renderPass = nullptr;
         LLGL::Sampler* sampler = nullptr;
     };
 
     struct GuiState {
         LLGL::PipelineLayout *layout = nullptr;
+        LLGL::ShaderProgram *program = nullptr;
         LLGL::PipelineState *pipeline = nullptr;
+        std::string shaders;
         LLGL::VertexFormat format;
         LLGL::ResourceHeap *heap = nullptr;
         LLGL::Buffer *uniform = nullptr;
         MeshState mesh;
     };
 
+    // связанные сущности (модели ресурса, меши модели), отсортированные по id
+    using ModelLinks = FlatSet<flecs::entity_t>;
+
     struct Presets {
         flecs::entity material;
         flecs::entity mesh;
@@ -150,9 +212,16 @@ namespace rise::rendering {
     };
 
     struct TextureResources {
-        SoaSlotMap<TextureState, std::set<flecs::entity_t>> states;
-        std::vector<std::pair<TextureState, TextureId>> toInit;
-        std::vector<TextureId> toRemove;
+        SoaSlotMap<TextureState, ModelLinks> states;
+        FrameVector<std::pair<TextureState, TextureId>> toInit;
+        FrameVector<TextureId> toRemove;
+        ImageLoader loader;
+        // текстуры с одинаковым файлом или содержимым используют один GPU объект
+        ResourceRegistry<LLGL::Texture *> registry;
+        // исходные файлы загруженных путей реестра для перезагрузки при их изменении,
+        // пустой список - путь и есть файл
+        std::map<std::string, std::vector<std::string>> sources;
+        LLGL::Texture *placeholder = nullptr;
     };
 
     enum ViewportSlots : int {
@@ -162,23 +231,22 @@ namespace rise::rendering {
     };
 
     struct ViewportResources {
-        SoaSlotMap<ViewportState, UpdatedViewportState, std::set<flecs::entity_t>> states;
-        std::vector<std::pair<ViewportState, ViewportId>> toInit;
-        std::vector<ViewportId> toRemove;
+        SoaSlotMap<ViewportState, UpdatedViewportState, ModelLinks> states;
+        // флаги UpdatedViewportState выставляют OnSet системы, в том числе с рабочих потоков
+        std::mutex updatedMutex;
+        FrameVector<std::pair<ViewportState, ViewportId>> toInit;
+        FrameVector<ViewportId> toRemove;
     };
 
     enum LightSlots : int {
         eLightState,
-        eLightShadowModels,
     };
 
     struct LightResources {
-        SoaSlotMap<LightState, std::map<Key, ShadowModel>> states;
-        std::vector<std::pair<LightState, LightId>> toInit;
-        std::vector<ModelId> toInitShadowModels;
-        std::vector<ModelId> toRemoveShadowModels;
-        std::vector<flecs::entity> toUpdate;
-        std::vector<LightId> toRemove;
+        SoaSlotMap<LightState> states;
+        FrameVector<std::pair<LightState, LightId>> toInit;
+        ChangeList toUpdate;
+        FrameVector<LightId> toRemove;
     };
 
     enum MaterialSlots : int {
@@ -187,42 +255,94 @@ namespace rise::rendering {
     };
 
     struct MaterialResources {
-        SoaSlotMap<MaterialState, std::set<flecs::entity_t>> states;
-        std::vector<std::pair<MaterialState, MaterialId>> toInit;
-        std::vector<flecs::entity> toUpdate;
-        std::vector<MaterialId> toRemove;
+        SoaSlotMap<MaterialState, ModelLinks> states;
+        FrameVector<std::pair<MaterialState, MaterialId>> toInit;
+        ChangeList toUpdate;
+        FrameVector<MaterialId> toRemove;
     };
 
     enum ModelSlots : int {
         eModelState,
         eModelMeshes,
+        eModelBounds,
+        // результат cullModels для frustum viewport модели в текущем кадре
+        eModelVisible,
+    };
+
+    struct SharedHeap {
+        LLGL::ResourceHeap *heap = nullptr;
+        uint32_t refs = 0;
     };
 
     struct ModelResources {
-        SoaSlotMap<ModelState, std::set<flecs::entity_t>> states;
-        std::vector<std::pair<ModelState, ModelId>> toInit;
-        std::vector<ModelId> toRemove;
-        std::vector<flecs::entity_t> toUpdateDescriptors;
-        std::vector<flecs::entity_t> toUpdateTransform;
+        SoaSlotMap<ModelState, ModelLinks, Aabb, uint8_t> states;
+        // модели с одинаковыми viewport, материалом и текстурами используют один набор
+        // дескрипторов, данные каждой модели приходят через поток инстансов
+        std::map<ModelResourceKeys, SharedHeap> heaps;
+        FrameVector<std::pair<ModelState, ModelId>> toInit;
+        FrameVector<ModelId> toRemove;
+        // модели, чьи ресурсы изменились, могут повторяться
+        FrameVector<flecs::entity_t> toUpdateDescriptors;
+        // отметки по слотам моделей и список без повторов: набор дескрипторов
+        // пересоздаётся не больше одного раза за кадр
+        DirtySlots dirtyDescriptors;
+        FrameVector<flecs::entity_t> descriptorsToRebuild;
+        ChangeList toUpdateTransform;
+        // промежуточные данные updateTransform, живут между кадрами, чтобы не выделять
+        // память заново
+        TransformBatch transformBatch;
+        std::vector<std::pair<Key, Key>> transformTargets;
+        std::vector<glm::mat4> transforms;
+        CullBatch cullBatch;
+        std::vector<Key> cullViewports;
     };
 
     enum MeshSlots : int {
         eMeshState,
+        eMeshModels,
     };
 
     struct MeshResources {
-        SoaSlotMap<MeshState> states;
-        std::vector<std::pair<MeshState, MeshId>> toInit;
-        std::vector<MeshId> toRemove;
+        // модели меша заносятся в updateTransform, удалённые и сменившие меш модели
+        // отсеиваются при следующей замене состояния
+        SoaSlotMap<MeshState, ModelLinks> states;
+        FrameVector<std::pair<MeshState, MeshId>> toInit;
+        FrameVector<MeshId> toRemove;
+        ResourceRegistry<MeshState> registry;
+        MeshImportStats imports;
     };
 
     struct Manager {
+        // память очередей команд кадра, сбрасывается в clearCommands. Очереди заполняются
+        // только из главного потока
+        FrameArena frame;
         TextureResources texture;
         ViewportResources viewport;
         ModelResources model;
         MeshResources mesh;
         MaterialResources material;
         LightResources light;
+        // события изменений прошлого кадра и сколько из них объединено с уже учтёнными
+        ChangeStats changes;
+        // выделения в очередях команд за прошлый кадр
+        AllocationStats allocations;
+
+        Manager() {
+            attach(texture.toRemove, frame);
+            attach(viewport.toRemove, frame);
+            attach(light.toRemove, frame);
+            attach(material.toRemove, frame);
+            attach(model.toRemove, frame);
+            attach(mesh.toRemove, frame);
+            attach(texture.toInit, frame);
+            attach(viewport.toInit, frame);
+            attach(light.toInit, frame);
+            attach(material.toInit, frame);
+            attach(model.toInit, frame);
+            attach(mesh.toInit, frame);
+            attach(model.toUpdateDescriptors, frame);
+            attach(model.descriptorsToRebuild, frame);
+        }
     };
 
     template<auto n, typename T>
@@ -255,7 +375,7 @@ namespace rise::rendering {
 
             f(state);
 
-            manager.texture.states.erase(rm.id);
+            res.states.erase(rm.id);
         }
 
         for (auto up : res.toInit) {
@@ -279,6 +399,11 @@ namespace rise::rendering {
     }
 
     struct ApplicationState {
+        explicit ApplicationState(unsigned workers) : jobs(workers) {}
+
+        // пул для разбиения тяжёлых шагов кадра и фоновой загрузки, создающий поток - главный.
+        // Объявлен первым, чтобы разрушаться последним, после ждущего его задачи загрузчика
+        JobSystem jobs;
         CoreState core;
         Manager manager;
         SceneState scene;
@@ -296,6 +421,13 @@ namespace rise::rendering {
         flecs::ref<ApplicationId> ref;
     };
 
+    // на рабочем потоке flecs OnSet система получает сущность, привязанную к стадии потока.
+    // Списки изменений разбираются в главном потоке, поэтому в них попадает сущность
+    // основного мира
+    inline flecs::entity mainWorldEntity(ApplicationRef app, flecs::entity e) {
+        return flecs::entity(app.ref.entity().world(), e.id());
+    }
+
     inline ApplicationState *getApp(flecs::entity e) {
         auto ref = e.get<ApplicationRef>()->ref;
         return ref->id;
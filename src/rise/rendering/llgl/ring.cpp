@@ -0,0 +1,69 @@
+#include "ring.hpp"
+
+namespace rise::rendering {
+    void FrameRing::init(LLGL::RenderSystem *renderer, LLGL::BufferDescriptor desc,
+            uint64_t regionSize, uint32_t frames) {
+        mRegionSize = regionSize;
+        mRegionFrames.assign(frames, 0);
+        mDesc = desc;
+
+        desc.size = regionSize * frames;
+        desc.cpuAccessFlags = LLGL::CPUAccessFlags::Write;
+        desc.miscFlags = LLGL::MiscFlags::DynamicUsage;
+        mBuffer = renderer->CreateBuffer(desc);
+    }
+
+    void FrameRing::release(LLGL::RenderSystem *renderer) {
+        end(renderer);
+        if (mBuffer) {
+            renderer->Release(*mBuffer);
+            mBuffer = nullptr;
+        }
+    }
+
+    void FrameRing::begin(LLGL::RenderSystem *renderer, uint64_t frame, uint64_t completed) {
+        auto region = frame % mRegionFrames.size();
+        mStats = {};
+        mBegin = mOffset = mEnd = mRegionSize * region;
+
+        // fence прошлого кадра этой области ещё не сработал
+        if (mRegionFrames[region] > completed) {
+            return;
+        }
+        mRegionFrames[region] = frame;
+        mEnd = mBegin + mRegionSize;
+
+        mData = reinterpret_cast<uint8_t *>(renderer->MapBuffer(*mBuffer,
+                LLGL::CPUAccess::WriteOnly, mBegin, mRegionSize));
+        ++mStats.maps;
+    }
+
+    void FrameRing::end(LLGL::RenderSystem *renderer) {
+        if (mData) {
+            renderer->UnmapBuffer(*mBuffer);
+            mData = nullptr;
+        }
+    }
+
+    uint64_t FrameRing::allocate(uint64_t size, uint64_t alignment) {
+        uint64_t offset = (mOffset + alignment - 1) / alignment * alignment;
+        if (!mData || offset + size > mEnd) {
+            ++mStats.overflows;
+            return npos;
+        }
+
+        mOffset = offset + size;
+        ++mStats.allocations;
+        mStats.bytes += size;
+        return offset;
+    }
+
+    LLGL::Buffer *FrameRing::fallback(LLGL::RenderSystem *renderer, void const *data,
+            uint64_t size) {
+        auto desc = mDesc;
+        desc.size = size;
+        ++mStats.fallbacks;
+        mStats.fallbackBytes += size;
+        return renderer->CreateBuffer(desc, data);
+    }
+}
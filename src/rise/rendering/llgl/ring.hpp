@@ -0,0 +1,86 @@
+#pragma once
+
+#include <LLGL/LLGL.h>
+#include <vector>
+#include <cstdint>
+
+namespace rise::rendering {
+    struct FrameRingStats {
+        uint32_t maps = 0;
+        uint32_t allocations = 0;
+        uint32_t overflows = 0;
+        // отрисовки, данные которых не поместились в область кадра и ушли в отдельный буфер
+        uint32_t fallbacks = 0;
+        uint64_t bytes = 0;
+        uint64_t fallbackBytes = 0;
+    };
+
+    // один большой буфер, разбитый на области по числу кадров в полёте; в каждом кадре
+    // отображается только область этого кадра, а данные выделяются из неё последовательными
+    // выровненными срезами. Область снова занимается только после сигнала fence кадра,
+    // который писал в неё прошлый раз
+    class FrameRing {
+    public:
+        static const uint64_t npos = ~uint64_t(0);
+
+        void init(LLGL::RenderSystem *renderer, LLGL::BufferDescriptor desc, uint64_t regionSize,
+                uint32_t frames);
+
+        void release(LLGL::RenderSystem *renderer);
+
+        // frame - номер записываемого кадра, completed - последний кадр, выполненный GPU.
+        // Если GPU ещё читает область, кадр обходится без неё: allocate возвращает npos
+        void begin(LLGL::RenderSystem *renderer, uint64_t frame, uint64_t completed);
+
+        void end(LLGL::RenderSystem *renderer);
+
+        // смещение среза в байтах от начала буфера или npos, если область кадра заполнена
+        uint64_t allocate(uint64_t size, uint64_t alignment);
+
+        // count элементов подряд; first - индекс первого из них, пригодный для firstInstance
+        template<typename T>
+        T *allocateArray(uint32_t count, uint64_t &first) {
+            auto offset = allocate(sizeof(T) * count, sizeof(T));
+            if (offset == npos) {
+                first = npos;
+                return nullptr;
+            }
+
+            first = offset / sizeof(T);
+            return reinterpret_cast<T *>(mData + (offset - mBegin));
+        }
+
+        template<typename T>
+        uint64_t push(T const &value) {
+            uint64_t first;
+            if (auto pDst = allocateArray<T>(1, first)) {
+                *pDst = value;
+            }
+            return first;
+        }
+
+        // запасной путь при переполнении: отдельный буфер с тем же описанием и данными data.
+        // Освобождать его нужно после кадра, см. ReleaseQueue
+        LLGL::Buffer *fallback(LLGL::RenderSystem *renderer, void const *data, uint64_t size);
+
+        LLGL::Buffer *buffer() const {
+            return mBuffer;
+        }
+
+        FrameRingStats const &stats() const {
+            return mStats;
+        }
+
+    private:
+        LLGL::Buffer *mBuffer = nullptr;
+        LLGL::BufferDescriptor mDesc;
+        uint8_t *mData = nullptr;
+        uint64_t mRegionSize = 0;
+        // кадр, который последним писал в каждую область
+        std::vector<uint64_t> mRegionFrames;
+        uint64_t mBegin = 0;
+        uint64_t mOffset = 0;
+        uint64_t mEnd = 0;
+        FrameRingStats mStats;
+    };
+}
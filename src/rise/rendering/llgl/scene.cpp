@@ -1,5 +1,6 @@
 #include "scene.hpp"
 #include "utils.hpp"
+#include "../glm.hpp"
 
 namespace rise::rendering {
     void regSceneState(flecs::entity e) {
@@ -12,15 +13,43 @@ namespace rise::rendering {
         auto &scene = state.scene;
         auto &presets = state.presets;
 
-        scene.format.AppendAttribute({"position", LLGL::Format::RGB32Float});
-        scene.format.AppendAttribute({"normal", LLGL::Format::RGB32Float});
-        scene.format.AppendAttribute({"color", LLGL::Format::RGB32Float});
-        scene.format.AppendAttribute({"texCoord", LLGL::Format::RG32Float});
+        // позиции отдельным потоком, чтобы проход теней читал только их
+        scene.format.AppendAttribute({"position", LLGL::Format::RGB32Float, 0});
+
+        scene.attributeFormat.AppendAttribute({"normal", LLGL::Format::RG16SNorm, 1}, true);
+        scene.attributeFormat.AppendAttribute({"texCoord", LLGL::Format::RG16Float, 3}, true);
+        scene.attributeFormat.AppendAttribute({"color", LLGL::Format::RGBA8UNorm, 2}, true);
+        scene.attributeFormat.SetSlot(1);
+
+        for (uint32_t i = 0; i != 4; ++i) {
+            scene.instanceFormat.AppendAttribute({"transform", i, LLGL::Format::RGBA32Float,
+                    4 + i, 1}, true);
+        }
+        scene.instanceFormat.SetSlot(2);
 
         scene.layout = scenePipeline::createLayout(core.renderer.get());
-        auto program = createShaderProgram(core.renderer.get(),
-                root + "/shaders/scene", scene.format);
-        scene.pipeline = scenePipeline::createPipeline(core.renderer.get(), scene.layout, program);
+        scene.shaders = root + "/shaders/scene";
+        scene.program = createShaderProgram(core.renderer.get(), scene.shaders,
+                {scene.format, scene.attributeFormat, scene.instanceFormat});
+        scene.pipeline = scenePipeline::createPipeline(core.renderer.get(), scene.layout,
+                scene.program);
+        watchShaders(state.core.watcher, scene.shaders);
+
+        // трансформации всех отрисовок кадра пишутся в одну область кольцевого буфера,
+        // вместо отдельного uniform буфера и map/unmap на каждую модель
+        LLGL::BufferDescriptor instancesDesc;
+        instancesDesc.bindFlags = LLGL::BindFlags::VertexBuffer;
+        instancesDesc.vertexAttribs = scene.instanceFormat.attributes;
+        scene.instances.init(core.renderer.get(), instancesDesc,
+                sizeof(scenePipeline::PerObject) * scenePipeline::maxInstances,
+                scenePipeline::framesInFlight);
+
+        // белая текстура 1x1 на время фоновой загрузки изображений
+        const uint8_t white[] = {255, 255, 255, 255};
+        state.manager.texture.placeholder = createTextureFromData(core.renderer.get(),
+                LLGL::ImageFormat::RGBA, white, 1, 1);
+        state.manager.texture.loader.setCompression(supportsCompression(core.renderer.get()));
+        state.manager.texture.loader.setJobs(state.jobs);
 
         auto ecs = e.world();
         presets.material = ecs.entity().set<RegTo>({e}).
@@ -38,27 +67,153 @@ namespace rise::rendering {
 
     void renderScene(flecs::entity, ApplicationRef applicationRef, ViewportRef viewportRef,
             MeshId meshId, ModelId modelId) {
-        auto cmdBuf = applicationRef.ref->id->core.cmdBuf;
-        cmdBuf->SetPipelineState(*applicationRef.ref->id->scene.pipeline);
+        auto &scene = applicationRef.ref->id->scene;
 
         auto position = *getOrDefault(viewportRef.ref.entity(), Position2D{0, 0});
         auto size = *getOrDefault(viewportRef.ref.entity(),
                 *applicationRef.ref.entity().get<Extent2D>());
         LLGL::Viewport viewport{position.x, position.y, size.width, size.height};
-        cmdBuf->SetViewport(viewport);
 
         auto &manager = applicationRef.ref->id->manager;
-        auto const &model = std::get<eModelState>(manager.model.states.at(modelId.id)).get();
+        auto &&row = manager.model.states.at(modelId.id);
+        auto const &model = std::get<eModelState>(row).get();
+        auto &bounds = std::get<eModelBounds>(row).get();
+        auto visible = std::get<eModelVisible>(row).get();
         auto const &mesh = std::get<eMeshState>(manager.mesh.states.at(meshId.id)).get();
 
-        if(mesh.vertices) {
+        if (!mesh.vertices || !model.heap) {
+            return;
+        }
+
+        // меш мог загрузиться позже, чем обновилась трансформация модели, тогда бокс
+        // в cullModels был пустым и модель проверяется здесь отдельно
+        if (bounds.empty()) {
+            bounds = transformAabb(mesh.bounds, model.transform);
+            auto const &viewportState = std::get<eViewportState>(
+                    manager.viewport.states.at(viewportRef.ref->id)).get();
+            visible = bounds.empty() || testAabb(viewportState.frustum, bounds);
+        }
+
+        if (!visible) {
+            ++scene.culling.culled;
+            return;
+        }
+        ++scene.culling.visible;
+
+        auto camera = *getOrDefault(viewportRef.ref.entity(), Position3D{0, 0, 0});
+        float distance = glm::distance(toGlm(camera), glm::vec3(model.transform[3]));
+
+        scene.queue.push(
+                scene.pipelines.get(scene.pipeline),
+                scene.heaps.get(model.resources),
+                scene.meshes.get(meshId.id),
+                sortKey::depth(distance, scenePipeline::farPlane),
+                ScenePacket{model.heap, meshId, viewport, {model.transform}});
+    }
+
+    void drawInstancesFallback(ApplicationState &app, std::vector<LLGL::Buffer *> buffers,
+            scenePipeline::PerObject const *objects, uint32_t count, uint32_t numIndices) {
+        auto &core = app.core;
+        auto renderer = core.renderer.get();
+
+        auto instances = app.scene.instances.fallback(renderer, objects,
+                sizeof(scenePipeline::PerObject) * count);
+        buffers.push_back(instances);
+        auto array = renderer->CreateBufferArray(static_cast<uint32_t>(buffers.size()),
+                buffers.data());
+
+        core.cmdBuf->SetVertexBufferArray(*array);
+        core.cmdBuf->DrawIndexedInstanced(numIndices, count, 0, 0, 0);
+        core.releases.push(array, core.frame);
+        core.releases.push(instances, core.frame);
+    }
+
+    struct SceneEmitter {
+        ApplicationState &app;
+        MeshState const *current = nullptr;
+        uint32_t numIndices = 0;
 
-            cmdBuf->SetResourceHeap(*model.heap);
-            cmdBuf->SetVertexBuffer(*mesh.vertices);
+        void pipeline(uint32_t handle) {
+            app.core.cmdBuf->SetPipelineState(*app.scene.pipelines[handle]);
+        }
+
+        void heap(uint32_t, ScenePacket const &packet) {
+            app.core.cmdBuf->SetViewport(packet.viewport);
+            app.core.cmdBuf->SetResourceHeap(*packet.heap);
+        }
+
+        void mesh(uint32_t, ScenePacket const &packet) {
+            auto cmdBuf = app.core.cmdBuf;
+            auto const &mesh = std::get<eMeshState>(
+                    app.manager.mesh.states.at(packet.mesh.id)).get();
+            cmdBuf->SetVertexBufferArray(*mesh.instanced);
             cmdBuf->SetIndexBuffer(*mesh.indices);
-            cmdBuf->DrawIndexed(mesh.numIndices, 0);
+            numIndices = mesh.numIndices;
+            current = &mesh;
+        }
+
+        void draw(ScenePacket const *packets, size_t count) {
+            auto cmdBuf = app.core.cmdBuf;
+            auto &scene = app.scene;
+
+            // без инстансинга каждая модель рисуется отдельным вызовом со своим firstInstance
+            size_t step = scene.instancing ? count : 1;
+            for (size_t i = 0; i < count; i += step) {
+                auto n = static_cast<uint32_t>(std::min(step, count - i));
+                uint64_t first;
+                auto pObjects = scene.instances.allocateArray<scenePipeline::PerObject>(n, first);
+                if (!pObjects) {
+                    // кольцо заполнено, отрисовки не теряются
+                    std::vector<scenePipeline::PerObject> objects(n);
+                    for (uint32_t j = 0; j != n; ++j) {
+                        objects[j] = packets[i + j].object;
+                    }
+                    drawInstancesFallback(app, {current->vertices, current->attributes},
+                            objects.data(), n, numIndices);
+                    cmdBuf->SetVertexBufferArray(*current->instanced);
+                } else {
+                    for (uint32_t j = 0; j != n; ++j) {
+                        pObjects[j] = packets[i + j].object;
+                    }
+                    cmdBuf->DrawIndexedInstanced(numIndices, n, 0, 0,
+                            static_cast<uint32_t>(first));
+                }
+                ++scene.stats.draws;
+                scene.stats.instances += n;
+            }
+        }
+    };
+
+    void flushSceneQueue(flecs::entity, ApplicationId app) {
+        auto &scene = app.id->scene;
+
+        scene.queue.sort();
+        scene.queue.flush(SceneEmitter{*app.id}, scene.stats);
+
+        scene.queue.clear();
+        scene.pipelines.clear();
+        scene.heaps.clear();
+        scene.meshes.clear();
+    }
+
+    void reloadSceneShaders(ApplicationState &state, std::vector<std::string> const &changed) {
+        auto &core = state.core;
+        auto &scene = state.scene;
+        if (!shadersChanged(changed, scene.shaders)) {
+            return;
+        }
+
+        auto program = reloadShaderProgram(core.renderer.get(), scene.shaders,
+                {scene.format, scene.attributeFormat, scene.instanceFormat});
+        if (!program) {
+            return;
         }
 
+        core.releases.push(scene.pipeline, core.frame);
+        core.releases.push(scene.program, core.frame);
+        scene.program = program;
+        scene.pipeline = scenePipeline::createPipeline(core.renderer.get(), scene.layout,
+                scene.program);
     }
 
     void importSceneState(flecs::world &ecs) {
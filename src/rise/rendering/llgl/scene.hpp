@@ -8,4 +8,14 @@ namespace rise::rendering {
 
     void renderScene(flecs::entity, ApplicationRef applicationRef, ViewportRef viewportRef,
             MeshId meshId, ModelId modelId);
+
+    // отрисовка, не поместившаяся в кольцо инстансов: данные уходят в отдельный буфер,
+    // который вместе с массивом буферов освобождается после кадра. Массив меша после
+    // вызова нужно установить заново
+    void drawInstancesFallback(ApplicationState &app, std::vector<LLGL::Buffer *> buffers,
+            scenePipeline::PerObject const *objects, uint32_t count, uint32_t numIndices);
+
+    void flushSceneQueue(flecs::entity, ApplicationId app);
+
+    void reloadSceneShaders(ApplicationState &state, std::vector<std::string> const &changed);
 }
\ No newline at end of file
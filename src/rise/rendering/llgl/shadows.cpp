@@ -1,4 +1,5 @@
 #include "shadows.hpp"
+#include "scene.hpp"
 #include "utils.hpp"
 #include "../glm.hpp"
 
@@ -12,62 +13,28 @@ namespace rise::rendering {
         e.set<LightId>({});
     }
 
-    void initShadowModels(flecs::entity, ApplicationId app) {
-        auto &shadows = app.id->shadows;
-        auto &manager = app.id->manager;
-
-        for (auto model : manager.light.toInitShadowModels) {
-            for (auto &&light : manager.light.states) {
-                auto &shadowModel = std::get<eLightShadowModels>(light).get();
-                auto &lightState = std::get<eLightState>(light).get();
-                LLGL::ResourceHeapDescriptor resourceHeapDesc;
-
-                resourceHeapDesc.pipelineLayout = app.id->shadows.layout;
-                resourceHeapDesc.resourceViews.emplace_back(
-                        std::get<eModelState>(manager.model.states.at(model.id)).get().uniform);
-                resourceHeapDesc.resourceViews.emplace_back(lightState.matrices);
-                resourceHeapDesc.resourceViews.emplace_back(lightState.parameters);
-                shadowModel.at(model.id).heap =
-                        app.id->core.renderer->CreateResourceHeap(resourceHeapDesc);
-            }
-        }
-    }
-
-    void removeShadowModels(flecs::entity, ApplicationId app) {
-        auto &manager = app.id->manager;
-        for (auto model : manager.light.toRemoveShadowModels) {
-            for (auto &&light : manager.light.states) {
-                auto &shadowModel = std::get<eLightShadowModels>(light).get();
-                app.id->core.renderer->Release(*shadowModel.at(model.id).heap);
-                shadowModel.erase(model.id);
-            }
-        }
-    }
-
     void initPointLight(flecs::entity e, ApplicationRef app, ViewportRef viewport, LightId &id) {
         if (id.id == NullKey) {
             auto &core = app.ref->id->core;
             auto &shadows = app.ref->id->shadows;
             auto &light = app.ref->id->manager.light;
 
-            auto &viewportModels = std::get<eViewportModels>(
-                    app.ref->id->manager.viewport.states.at(viewport.ref->id)).get();
-
-            std::map<Key, ShadowModel> shadowModels;
-            for (auto model : viewportModels) {
-                auto &pm = *flecs::entity(e.world(), model).get<ModelId>();
-                shadowModels.emplace(pm.id, ShadowModel{});
-                light.toInitShadowModels.push_back({pm});
-            }
-
-            std::tuple init{LightState{}, std::move(shadowModels)};
-            id.id = app.ref->id->manager.light.states.push_back(std::move(init));
+            id.id = app.ref->id->manager.light.states.push_back(std::tuple{LightState{}});
             e.add_trait<Initialized, LightId>();
             auto renderer = core.renderer.get();
             auto matrices = createUniformBuffer<shadowPipeline::PerLightMatrices>(renderer);
             auto parameters = createUniformBuffer<shadowPipeline::PerLightParameters>(renderer);
-            light.toInit.emplace_back(LightState{matrices, parameters, 0}, id);
-            light.toUpdate.push_back(e);
+
+            // трансформации моделей приходят через поток инстансов, поэтому набор дескрипторов
+            // нужен один на источник света, а не на каждую пару источник-модель
+            LLGL::ResourceHeapDescriptor resourceHeapDesc;
+            resourceHeapDesc.pipelineLayout = shadows.layout;
+            resourceHeapDesc.resourceViews.emplace_back(matrices);
+            resourceHeapDesc.resourceViews.emplace_back(parameters);
+            auto heap = renderer->CreateResourceHeap(resourceHeapDesc);
+
+            light.toInit.emplace_back(LightState{matrices, parameters, heap, 0}, id);
+            light.toUpdate.push(e);
 
 
         } else {
@@ -79,7 +46,6 @@ namespace rise::rendering {
         auto &manager = app.ref->id->manager;
         std::get<eViewportUpdated>(manager.viewport.states.at(viewport.ref->id)).get().light = true;
         app.ref->id->manager.light.toRemove.push_back(id);
-        auto& models = std::get<eLightShadowModels>(manager.light.states.at(id.id)).get();
     }
 
     void unregPointLight(flecs::entity e) {
@@ -150,7 +116,7 @@ namespace rise::rendering {
 
     void catchShadowsLightUpdate(flecs::entity e, ApplicationRef app) {
         auto &manager = app.ref->id->manager;
-        manager.light.toUpdate.push_back(e);
+        manager.light.toUpdate.push(mainWorldEntity(app, e));
     }
 
     void updateShadowMaps(flecs::entity e, ApplicationRef ref, ViewportRef viewportRef,
@@ -161,37 +127,59 @@ namespace rise::rendering {
         auto &updated = std::get<eViewportUpdated>(row).get();
         auto &viewport = std::get<eViewportState>(row).get();
         auto cmd = ref.ref->id->core.cmdBuf;
+        auto &scene = ref.ref->id->scene;
 
         auto &light = std::get<eLightState>(manager.light.states.at(lightId.id)).get();
         if(light.matrices == nullptr) {
             return;
         }
 
-        auto &shadowModels = std::get<eLightShadowModels>(
-                manager.light.states.at(lightId.id)).get();
+        auto &models = std::get<eViewportModels>(row).get();
 
         std::array<LLGL::ClearValue, 6> clearValues = {};
         cmd->BeginRenderPass(*viewport.cubeTarget[light.id].target, shadows.renderPass, 6,
                 clearValues.data());
         cmd->SetPipelineState(*viewport.cubeTarget[light.id].pipeline);
         cmd->Clear(LLGL::ClearFlags::Depth, 0, true);
+        cmd->SetResourceHeap(*light.heap);
 
 
-        for (auto p : shadowModels) {
-            cmd->SetResourceHeap(*p.second.heap);
-            auto &meshes = std::get<eModelMeshes>(manager.model.states.at(p.first)).get();
-            for (auto &mesh : meshes) {
-                auto meshE = flecs::entity(e.world(), mesh);
-                if (meshE.owns<Shadow>()) {
-                    auto meshId = meshE.get<MeshId>();
-                    auto &meshState = std::get<eMeshState>(
-                            manager.mesh.states.at(meshId->id)).get();
-                    if(meshState.vertices) {
-                        cmd->SetVertexBuffer(*meshState.vertices);
-                        cmd->SetIndexBuffer(*meshState.indices);
-                        cmd->DrawIndexed(meshState.numIndices, 0);
-                    }
+        float radius = std::min(light.distance, scenePipeline::farPlane);
+
+        for (auto model : models) {
+            auto modelE = flecs::entity(e.world(), model);
+            auto modelId = modelE.get<ModelId>();
+            auto meshId = modelE.get<MeshId>();
+            if (!modelE.owns<Shadow>() || !meshId || meshId->id == NullKey ||
+                    modelId->id == NullKey) {
+                continue;
+            }
+
+            auto &&modelRow = manager.model.states.at(modelId->id);
+            auto const &bounds = std::get<eModelBounds>(modelRow).get();
+            if (!bounds.empty() && !testSphere(bounds, light.position, radius)) {
+                ++scene.culling.shadowCulled;
+                continue;
+            }
+            ++scene.culling.shadowVisible;
+
+            auto &meshState = std::get<eMeshState>(manager.mesh.states.at(meshId->id)).get();
+            if (meshState.vertices) {
+                auto const &modelState = std::get<eModelState>(modelRow).get();
+                scenePipeline::PerObject object{modelState.transform};
+                auto first = scene.instances.push(object);
+
+                cmd->SetIndexBuffer(*meshState.indices);
+                if (first == FrameRing::npos) {
+                    // кольцо заполнено, тень рисуется из отдельного буфера
+                    drawInstancesFallback(*ref.ref->id, {meshState.vertices}, &object, 1,
+                            meshState.numIndices);
+                    continue;
                 }
+
+                cmd->SetVertexBufferArray(*meshState.shadowInstanced);
+                cmd->DrawIndexedInstanced(meshState.numIndices, 1, 0, 0,
+                        static_cast<uint32_t>(first));
             }
         }
         cmd->EndRenderPass();
@@ -226,11 +214,18 @@ namespace rise::rendering {
         auto &presets = state.presets;
 
         shadows.format.AppendAttribute({"position", LLGL::Format::RGB32Float});
-        shadows.format.SetStride(sizeof(float) * (3 + 3 + 3 + 2));
+
+        for (uint32_t i = 0; i != 4; ++i) {
+            shadows.instanceFormat.AppendAttribute({"transform", i, LLGL::Format::RGBA32Float,
+                    1 + i, 1}, true);
+        }
+        shadows.instanceFormat.SetSlot(1);
 
         shadows.layout = shadowPipeline::createLayout(core.renderer.get());
-        shadows.program = createShaderProgram(core.renderer.get(),
-                root + "/shaders/shadows", shadows.format);
+        shadows.shaders = root + "/shaders/shadows";
+        shadows.program = createShaderProgram(core.renderer.get(), shadows.shaders,
+                {shadows.format, shadows.instanceFormat});
+        watchShaders(state.core.watcher, shadows.shaders);
         shadows.renderPass = createDepthRenderPass(state.core.renderer.get());
 
         LLGL::SamplerDescriptor samplerInfo = {};
@@ -245,4 +240,47 @@ namespace rise::rendering {
         samplerInfo.borderColor = {1, 1, 1, 1};
         shadows.sampler = state.core.renderer->CreateSampler(samplerInfo);
     }
+
+    // конвейеры теней создаются для каждой кубической карты во всех viewport
+    void reloadShadowShaders(flecs::world &ecs, ApplicationState &state,
+            std::vector<std::string> const &changed) {
+        auto &core = state.core;
+        auto &shadows = state.shadows;
+        if (!shadersChanged(changed, shadows.shaders)) {
+            return;
+        }
+
+        auto program = reloadShaderProgram(core.renderer.get(), shadows.shaders,
+                {shadows.format, shadows.instanceFormat});
+        if (!program) {
+            return;
+        }
+
+        core.releases.push(shadows.program, core.frame);
+        shadows.program = program;
+
+        flecs::filter filter(ecs);
+        filter.include<ViewportId>();
+
+        for (auto it : ecs.filter(filter)) {
+            for (auto row : it) {
+                auto e = it.entity(row);
+                auto ref = e.get<ApplicationRef>();
+                if (!e.has_trait<Initialized, ViewportId>() || !ref || ref->ref->id != &state) {
+                    continue;
+                }
+
+                auto &viewport = std::get<eViewportState>(
+                        state.manager.viewport.states.at(e.get<ViewportId>()->id)).get();
+                for (auto &target : viewport.cubeTarget) {
+                    if (target.target) {
+                        core.releases.push(target.pipeline, core.frame);
+                        target.pipeline = shadowPipeline::createPipeline(core.renderer.get(),
+                                shadows.layout, shadows.program,
+                                target.target->GetRenderPass());
+                    }
+                }
+            }
+        }
+    }
 }
@@ -7,13 +7,12 @@ namespace rise::rendering {
 
     void initShadowsState(flecs::entity, ApplicationState &state, Path const &path);
 
-    void initShadowModels(flecs::entity, ApplicationId app);
-
-    void removeShadowModels(flecs::entity, ApplicationId app);
-
     void updateShadowMaps(flecs::entity, ApplicationRef ref, ViewportRef viewportRef,
             LightId lightId);
 
     void updateLightUniforms(flecs::entity, ApplicationId app);
 
+    void reloadShadowShaders(flecs::world &ecs, ApplicationState &state,
+            std::vector<std::string> const &changed);
+
 }
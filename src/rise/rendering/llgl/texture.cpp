@@ -3,19 +3,25 @@
 #include "texture.hpp"
 #include "stb_image.h"
 #include "utils.hpp"
+#include "cache.hpp"
+#include <cstdio>
 
 namespace rise::rendering {
     void regTexture(flecs::entity e) {
-        if (!e.has<Path>()) e.set<Path>({});
+        if (!e.has<Path>() && !e.has<OrmPath>()) e.set<Path>({});
         e.set<TextureId>({});
     }
 
     void initTexture(flecs::entity e, ApplicationRef app, TextureId &id) {
         if (!e.has_trait<Initialized, TextureId>()) {
-            std::tuple init{TextureState{}, std::set<flecs::entity_t>{}};
+            std::tuple init{TextureState{}, ModelLinks{}};
             id.id = app.ref->id->manager.texture.states.push_back(std::move(init));
             e.add_trait<Initialized, TextureId>();
-            e.patch<Path>([](auto) {});
+            if (e.has<OrmPath>()) {
+                e.patch<OrmPath>([](auto) {});
+            } else {
+                e.patch<Path>([](auto) {});
+            }
         }
     }
 
@@ -28,46 +34,128 @@ namespace rise::rendering {
 
     void removeTexture(flecs::entity, ApplicationRef app, TextureId id) {
         app.ref->id->manager.texture.toRemove.push_back(id);
+        app.ref->id->manager.texture.registry.cancel(id.id);
+    }
+
+    // текстуры с уже загруженным или загружающимся файлом получают общий GPU объект, иначе
+    // изображение отправляется на загрузку в фоне, до её окончания в наборах дескрипторов
+    // остаётся текстура-заглушка
+    void loadTexture(TextureResources &textures, std::string const &file,
+            std::vector<std::string> const &channels) {
+        if (channels.empty()) {
+            textures.loader.push(file);
+        } else {
+            textures.loader.pushPacked(file, channels);
+        }
+    }
+
+    void requestTexture(ApplicationState &app, TextureId texture, std::string const &file,
+            std::vector<std::string> channels) {
+        auto &textures = app.manager.texture;
+        ResourceRegistry<LLGL::Texture *>::Entry const *entry = nullptr;
+        if (textures.registry.request(file, texture.id, entry)) {
+            for (auto const &source : channels.empty() ? std::vector{file} : channels) {
+                app.core.watcher.watch(source);
+            }
+            loadTexture(textures, file, channels);
+            textures.sources[file] = std::move(channels);
+        } else if (entry->ready) {
+            textures.registry.retain(entry->identity);
+            textures.toInit.emplace_back(TextureState{entry->value}, texture);
+        }
     }
 
-    // при изменении пути до файла отложенно обновляем текстуру
     void updateTexture(flecs::entity, ApplicationRef ref, TextureId texture, Path const &path) {
         auto &root = ref.ref.entity().get<Path>()->file;
-        auto &manager = ref.ref->id->manager;
-        auto renderer = ref.ref->id->core.renderer.get();
-
-        auto file = root + "/textures/" + path.file;
-
-        int width = 0, height = 0, components = 0;
-        auto image = stbi_load(file.c_str(), &width, &height, &components, 0);
-
-        if (image) {
-            TextureState state;
-            LLGL::ImageFormat format;
-            switch (components) {
-            case 1:
-                format = LLGL::ImageFormat::R;
-                break;
-            case 2:
-                format = LLGL::ImageFormat::RG;
-                break;
-            case 3:
-                format = LLGL::ImageFormat::RGB;
-                break;
-            case 4:
-                format = LLGL::ImageFormat::RGBA;
-                break;
-            default:
-                throw std::runtime_error("undefined format");
+        auto file = normalizePath(root + "/textures/" + path.file);
+        requestTexture(*ref.ref->id, texture, file, {});
+    }
+
+    // три одноканальные карты упаковываются загрузчиком в одну текстуру, кэш хранится рядом
+    // с картой ambient occlusion. Общую карту ao делят наборы с разными roughness и metallic,
+    // поэтому ключ реестра и имя кэша строятся из хэша всех трёх путей
+    void updateOrmTexture(flecs::entity, ApplicationRef ref, TextureId texture,
+            OrmPath const &path) {
+        auto folder = ref.ref.entity().get<Path>()->file + "/textures/";
+        std::vector<std::string> channels{normalizePath(folder + path.ao),
+                normalizePath(folder + path.roughness), normalizePath(folder + path.metallic)};
+
+        uint64_t hash = fnvOffset;
+        for (auto const &channel : channels) {
+            // вместе с завершающим нулём, чтобы "a", "bc" и "ab", "c" не совпадали
+            hash = hashBytes(channel.c_str(), channel.size() + 1, hash);
+        }
+        char suffix[24];
+        std::snprintf(suffix, sizeof(suffix), ".%016llx.orm",
+                static_cast<unsigned long long>(hash));
+
+        auto file = channels[0] + suffix;
+        requestTexture(*ref.ref->id, texture, file, std::move(channels));
+    }
+
+    // пользователи изменённых файлов получат новую текстуру по окончании загрузки, наборы
+    // дескрипторов их моделей пересоздадутся через toUpdateDescriptors
+    void reloadTextures(ApplicationState &app, std::vector<std::string> const &changed) {
+        auto &textures = app.manager.texture;
+        for (auto const &[file, channels] : textures.sources) {
+            bool affected = false;
+            for (auto const &source : channels.empty() ? std::vector{file} : channels) {
+                affected = affected ||
+                        std::find(changed.begin(), changed.end(), source) != changed.end();
             }
-            state.val = createTextureFromData(renderer, format, image, width, height);
 
-            manager.texture.toInit.emplace_back(state, texture);
+            if (affected && textures.registry.reload(file)) {
+                loadTexture(textures, file, channels);
+            }
+        }
+    }
 
-            stbi_image_free(image);
-        } else {
-            std::cerr << "failed to load image from file: " << file << std::endl;
+    // сохранения во время загрузки не теряются: путь загружается снова с новым файлом
+    void reloadDirtyTextures(TextureResources &textures) {
+        for (auto const &file : textures.registry.takeDirty()) {
+            auto channels = textures.sources.find(file);
+            if (channels != textures.sources.end() && textures.registry.reload(file)) {
+                loadTexture(textures, file, channels->second);
+            }
+        }
+    }
+
+    void pollTextures(flecs::entity, ApplicationId app) {
+        auto &textures = app.id->manager.texture;
+        auto renderer = app.id->core.renderer.get();
+
+        std::vector<LoadedImage> images;
+        textures.loader.poll(images);
+
+        for (auto &image : images) {
+            // все текстуры с этим путём удалены или сменили путь, пока изображение загружалось
+            if (!textures.registry.waiting(image.file)) {
+                continue;
+            }
+
+            if (!image.loaded) {
+                std::cerr << "failed to load image from file: " << image.file << std::endl;
+                textures.registry.fail(image.file);
+                continue;
+            }
+
+            // то же изображение уже загружено по другому пути
+            LLGL::Texture *texture;
+            if (auto shared = textures.registry.findHash(image.hash)) {
+                texture = shared->value;
+            } else {
+                texture = createTexture(renderer, image.texture);
+            }
+
+            auto users = textures.registry.complete(image.file, texture, texture, image.hash,
+                    image.texture.data.size());
+            for (auto user : users) {
+                textures.registry.retain(texture);
+                textures.toInit.emplace_back(TextureState{texture}, TextureId{user});
+            }
         }
+
+        reloadDirtyTextures(textures);
     }
 
     void regTextureToModel(flecs::entity e, ApplicationRef app, flecs::entity te) {
@@ -104,27 +192,11 @@ namespace rise::rendering {
         unregTextureFromModel(e, app, t.e);
     }
 
-    void regMetTextureToModel(flecs::entity e, ApplicationRef app, MetallicTexture t) {
-        regTextureToModel(e, app, t.e);
-    }
-
-    void unregMetTextureFromModel(flecs::entity e, ApplicationRef app, MetallicTexture t) {
-        unregTextureFromModel(e, app, t.e);
-    }
-
-    void regRoughTextureToModel(flecs::entity e, ApplicationRef app, RoughnessTexture t) {
-        regTextureToModel(e, app, t.e);
-    }
-
-    void unregRoughTextureFromModel(flecs::entity e, ApplicationRef app, RoughnessTexture t) {
-        unregTextureFromModel(e, app, t.e);
-    }
-
-    void regAoTextureToModel(flecs::entity e, ApplicationRef app, AoTexture t) {
+    void regOrmTextureToModel(flecs::entity e, ApplicationRef app, PackedOrmTexture t) {
         regTextureToModel(e, app, t.e);
     }
 
-    void unregAoTextureFromModel(flecs::entity e, ApplicationRef app, AoTexture t) {
+    void unregOrmTextureFromModel(flecs::entity e, ApplicationRef app, PackedOrmTexture t) {
         unregTextureFromModel(e, app, t.e);
     }
 
@@ -140,19 +212,14 @@ namespace rise::rendering {
                 kind(flecs::OnSet).each(regDifTextureToModel);
         ecs.system<const ApplicationRef, const AlbedoTexture>("unregDifTextureToModel", "ModelId").
                 kind(EcsUnSet).each(unregDifTextureFromModel);
-        ecs.system<const ApplicationRef, const MetallicTexture>("regMetTextureToModel", "ModelId").
-                kind(flecs::OnSet).each(regMetTextureToModel);
-        ecs.system<const ApplicationRef, const MetallicTexture>("unregMetTextureToModel", "ModelId").
-                kind(EcsUnSet).each(unregMetTextureFromModel);
-        ecs.system<const ApplicationRef, const RoughnessTexture>("regRoughTextureToModel", "ModelId").
-                kind(flecs::OnSet).each(regRoughTextureToModel);
-        ecs.system<const ApplicationRef, const RoughnessTexture>("unregRoughTextureToModel", "ModelId").
-                kind(EcsUnSet).each(unregRoughTextureFromModel);
-        ecs.system<const ApplicationRef, const AoTexture>("regAoTextureToModel", "ModelId").
-                kind(flecs::OnSet).each(regAoTextureToModel);
-        ecs.system<const ApplicationRef, const AoTexture>("unregAoTextureToModel", "ModelId").
-                kind(EcsUnSet).each(unregAoTextureFromModel);
+        ecs.system<const ApplicationRef, const PackedOrmTexture>("regOrmTextureToModel", "ModelId").
+                kind(flecs::OnSet).each(regOrmTextureToModel);
+        ecs.system<const ApplicationRef, const PackedOrmTexture>("unregOrmTextureToModel", "ModelId").
+                kind(EcsUnSet).each(unregOrmTextureFromModel);
         ecs.system<const ApplicationRef, const TextureId, const Path>("updateTexture",
                 "Texture, TRAIT | Initialized > TextureId").kind(flecs::OnSet).each(updateTexture);
+        ecs.system<const ApplicationRef, const TextureId, const OrmPath>("updateOrmTexture",
+                "Texture, TRAIT | Initialized > TextureId").kind(flecs::OnSet).
+                each(updateOrmTexture);
     }
 }
\ No newline at end of file
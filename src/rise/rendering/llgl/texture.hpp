@@ -4,4 +4,8 @@
 
 namespace rise::rendering {
     void importTexture(flecs::world &ecs);
+
+    void pollTextures(flecs::entity, ApplicationId app);
+
+    void reloadTextures(ApplicationState &app, std::vector<std::string> const &changed);
 }
@@ -0,0 +1,167 @@
+#include "transform.hpp"
+
+#if defined(__AVX2__)
+#define RISE_TRANSFORM_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define RISE_TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace rise::rendering {
+    void TransformBatch::push(glm::vec3 const &position, glm::quat const &rotation,
+            glm::vec3 const &scale) {
+        px.push_back(position.x);
+        py.push_back(position.y);
+        pz.push_back(position.z);
+        qx.push_back(rotation.x);
+        qy.push_back(rotation.y);
+        qz.push_back(rotation.z);
+        qw.push_back(rotation.w);
+        sx.push_back(scale.x);
+        sy.push_back(scale.y);
+        sz.push_back(scale.z);
+    }
+
+    void TransformBatch::clear() {
+        for (auto array : {&px, &py, &pz, &qx, &qy, &qz, &qw, &sx, &sy, &sz}) {
+            array->clear();
+        }
+    }
+
+    void composeTransformsScalar(TransformBatch const &batch, size_t begin, size_t end,
+            glm::mat4 *out) {
+        for (size_t i = begin; i != end; ++i) {
+            float x = batch.qx[i], y = batch.qy[i], z = batch.qz[i], w = batch.qw[i];
+            float xx = x * x, yy = y * y, zz = z * z;
+            float xy = x * y, xz = x * z, yz = y * z;
+            float wx = w * x, wy = w * y, wz = w * z;
+
+            auto &m = out[i];
+            m[0] = glm::vec4(1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy), 0) * batch.sx[i];
+            m[1] = glm::vec4(2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx), 0) * batch.sy[i];
+            m[2] = glm::vec4(2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy), 0) * batch.sz[i];
+            m[3] = glm::vec4(batch.px[i], batch.py[i], batch.pz[i], 1);
+        }
+    }
+
+#if defined(RISE_TRANSFORM_AVX2)
+    namespace {
+        // столбцы по компонентам для 8 моделей -> столбец каждой модели, половинами по 4
+        void storeColumn(__m256 x, __m256 y, __m256 z, __m256 w, float *dst) {
+            for (int half = 0; half != 2; ++half) {
+                __m128 hx = half ? _mm256_extractf128_ps(x, 1) : _mm256_castps256_ps128(x);
+                __m128 hy = half ? _mm256_extractf128_ps(y, 1) : _mm256_castps256_ps128(y);
+                __m128 hz = half ? _mm256_extractf128_ps(z, 1) : _mm256_castps256_ps128(z);
+                __m128 hw = half ? _mm256_extractf128_ps(w, 1) : _mm256_castps256_ps128(w);
+                _MM_TRANSPOSE4_PS(hx, hy, hz, hw);
+                float *base = dst + half * 64;
+                _mm_storeu_ps(base, hx);
+                _mm_storeu_ps(base + 16, hy);
+                _mm_storeu_ps(base + 32, hz);
+                _mm_storeu_ps(base + 48, hw);
+            }
+        }
+    }
+
+    void composeTransforms(TransformBatch const &batch, size_t begin, size_t end,
+            glm::mat4 *out) {
+        size_t i = begin;
+
+        __m256 one = _mm256_set1_ps(1.0f);
+        __m256 two = _mm256_set1_ps(2.0f);
+        __m256 zero = _mm256_setzero_ps();
+        for (; i + 8 <= end; i += 8) {
+            __m256 x = _mm256_loadu_ps(&batch.qx[i]);
+            __m256 y = _mm256_loadu_ps(&batch.qy[i]);
+            __m256 z = _mm256_loadu_ps(&batch.qz[i]);
+            __m256 w = _mm256_loadu_ps(&batch.qw[i]);
+            __m256 sx = _mm256_loadu_ps(&batch.sx[i]);
+            __m256 sy = _mm256_loadu_ps(&batch.sy[i]);
+            __m256 sz = _mm256_loadu_ps(&batch.sz[i]);
+
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+            auto diag = [&](__m256 a, __m256 b) {
+                return _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(a, b)));
+            };
+            auto sum = [&](__m256 a, __m256 b) {
+                return _mm256_mul_ps(two, _mm256_add_ps(a, b));
+            };
+            auto diff = [&](__m256 a, __m256 b) {
+                return _mm256_mul_ps(two, _mm256_sub_ps(a, b));
+            };
+
+            float *dst = &out[i][0][0];
+            storeColumn(_mm256_mul_ps(diag(yy, zz), sx), _mm256_mul_ps(sum(xy, wz), sx),
+                    _mm256_mul_ps(diff(xz, wy), sx), zero, dst);
+            storeColumn(_mm256_mul_ps(diff(xy, wz), sy), _mm256_mul_ps(diag(xx, zz), sy),
+                    _mm256_mul_ps(sum(yz, wx), sy), zero, dst + 4);
+            storeColumn(_mm256_mul_ps(sum(xz, wy), sz), _mm256_mul_ps(diff(yz, wx), sz),
+                    _mm256_mul_ps(diag(xx, yy), sz), zero, dst + 8);
+            storeColumn(_mm256_loadu_ps(&batch.px[i]), _mm256_loadu_ps(&batch.py[i]),
+                    _mm256_loadu_ps(&batch.pz[i]), one, dst + 12);
+        }
+
+        composeTransformsScalar(batch, i, end, out);
+    }
+#elif defined(RISE_TRANSFORM_SSE)
+    namespace {
+        // столбцы по компонентам для 4 моделей -> столбец каждой модели
+        void storeColumn(__m128 x, __m128 y, __m128 z, __m128 w, float *dst) {
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(dst, x);
+            _mm_storeu_ps(dst + 16, y);
+            _mm_storeu_ps(dst + 32, z);
+            _mm_storeu_ps(dst + 48, w);
+        }
+    }
+
+    void composeTransforms(TransformBatch const &batch, size_t begin, size_t end,
+            glm::mat4 *out) {
+        size_t i = begin;
+
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 two = _mm_set1_ps(2.0f);
+        __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= end; i += 4) {
+            __m128 x = _mm_loadu_ps(&batch.qx[i]);
+            __m128 y = _mm_loadu_ps(&batch.qy[i]);
+            __m128 z = _mm_loadu_ps(&batch.qz[i]);
+            __m128 w = _mm_loadu_ps(&batch.qw[i]);
+            __m128 sx = _mm_loadu_ps(&batch.sx[i]);
+            __m128 sy = _mm_loadu_ps(&batch.sy[i]);
+            __m128 sz = _mm_loadu_ps(&batch.sz[i]);
+
+            __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+            auto diag = [&](__m128 a, __m128 b) {
+                return _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(a, b)));
+            };
+            auto sum = [&](__m128 a, __m128 b) { return _mm_mul_ps(two, _mm_add_ps(a, b)); };
+            auto diff = [&](__m128 a, __m128 b) { return _mm_mul_ps(two, _mm_sub_ps(a, b)); };
+
+            float *dst = &out[i][0][0];
+            storeColumn(_mm_mul_ps(diag(yy, zz), sx), _mm_mul_ps(sum(xy, wz), sx),
+                    _mm_mul_ps(diff(xz, wy), sx), zero, dst);
+            storeColumn(_mm_mul_ps(diff(xy, wz), sy), _mm_mul_ps(diag(xx, zz), sy),
+                    _mm_mul_ps(sum(yz, wx), sy), zero, dst + 4);
+            storeColumn(_mm_mul_ps(sum(xz, wy), sz), _mm_mul_ps(diff(yz, wx), sz),
+                    _mm_mul_ps(diag(xx, yy), sz), zero, dst + 8);
+            storeColumn(_mm_loadu_ps(&batch.px[i]), _mm_loadu_ps(&batch.py[i]),
+                    _mm_loadu_ps(&batch.pz[i]), one, dst + 12);
+        }
+
+        composeTransformsScalar(batch, i, end, out);
+    }
+#else
+    void composeTransforms(TransformBatch const &batch, size_t begin, size_t end,
+            glm::mat4 *out) {
+        composeTransformsScalar(batch, begin, end, out);
+    }
+#endif
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace rise::rendering {
+    // входные данные пакетного построения матриц моделей: каждая компонента лежит в своём
+    // массиве, чтобы ядро загружало по 4 или 8 моделей одной инструкцией
+    struct TransformBatch {
+        std::vector<float> px, py, pz;
+        std::vector<float> qx, qy, qz, qw;
+        std::vector<float> sx, sy, sz;
+
+        void push(glm::vec3 const &position, glm::quat const &rotation, glm::vec3 const &scale);
+
+        size_t size() const {
+            return px.size();
+        }
+
+        void clear();
+    };
+
+    // моделей на задачу при параллельном построении, кратно ширине AVX2
+    constexpr size_t transformGrain = 1024;
+
+    // out[i] = translate(position) * mat4_cast(rotation) * scale(scale) для i из [begin, end).
+    // Основной цикл обрабатывает по 8 моделей с AVX2 или по 4 с SSE, остаток и прочие
+    // платформы - скалярный вариант. Разные диапазоны можно считать параллельно
+    void composeTransforms(TransformBatch const &batch, size_t begin, size_t end,
+            glm::mat4 *out);
+
+    void composeTransformsScalar(TransformBatch const &batch, size_t begin, size_t end,
+            glm::mat4 *out);
+}
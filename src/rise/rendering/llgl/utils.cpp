@@ -1,9 +1,11 @@
 #include "utils.hpp"
+#include "cache.hpp"
 
 #define LLGL_ENABLE_UTILITY
 
 #include <LLGL/Utility.h>
 #include <filesystem>
+#include <algorithm>
 
 namespace rise::rendering {
     LLGL::Texture *createTextureFromData(LLGL::RenderSystem *renderer, LLGL::ImageFormat format,
@@ -33,6 +35,90 @@ namespace rise::rendering {
         return renderer->CreateTexture(texDesc, &imageDesc);
     }
 
+    LLGL::Format textureFormat(TextureCodec codec) {
+        switch (codec) {
+            case TextureCodec::R8:
+                return LLGL::Format::R8UNorm;
+            case TextureCodec::RG8:
+                return LLGL::Format::RG8UNorm;
+            case TextureCodec::RGBA8:
+                return LLGL::Format::RGBA8UNorm;
+            case TextureCodec::BC1:
+                return LLGL::Format::BC1UNorm;
+            case TextureCodec::BC3:
+                return LLGL::Format::BC3UNorm;
+            case TextureCodec::BC4:
+                return LLGL::Format::BC4UNorm;
+            case TextureCodec::BC5:
+                return LLGL::Format::BC5UNorm;
+        }
+        throw std::runtime_error("undefined texture codec");
+    }
+
+    LLGL::ImageFormat imageFormat(TextureCodec codec) {
+        switch (codec) {
+            case TextureCodec::R8:
+                return LLGL::ImageFormat::R;
+            case TextureCodec::RG8:
+                return LLGL::ImageFormat::RG;
+            case TextureCodec::RGBA8:
+                return LLGL::ImageFormat::RGBA;
+            case TextureCodec::BC1:
+                return LLGL::ImageFormat::BC1;
+            case TextureCodec::BC3:
+                return LLGL::ImageFormat::BC3;
+            case TextureCodec::BC4:
+                return LLGL::ImageFormat::BC4;
+            case TextureCodec::BC5:
+                return LLGL::ImageFormat::BC5;
+        }
+        throw std::runtime_error("undefined texture codec");
+    }
+
+    LLGL::Texture *createTexture(LLGL::RenderSystem *renderer, TextureData const &data) {
+        LLGL::TextureDescriptor texDesc;
+        texDesc.type = LLGL::TextureType::Texture2D;
+        texDesc.format = textureFormat(data.codec);
+        texDesc.extent = {data.width, data.height, 1u};
+        texDesc.mipLevels = data.levels();
+        // уровни уже построены на CPU, генерация mip средствами API не нужна
+        texDesc.miscFlags = 0;
+
+        auto texture = renderer->CreateTexture(texDesc);
+
+        uint32_t width = data.width;
+        uint32_t height = data.height;
+        for (uint32_t level = 0; level != data.levels(); ++level) {
+            LLGL::SrcImageDescriptor imageDesc;
+            imageDesc.format = imageFormat(data.codec);
+            imageDesc.dataType = LLGL::DataType::UInt8;
+            imageDesc.data = data.data.data() + data.offsets[level];
+            imageDesc.dataSize = data.offsets[level + 1] - data.offsets[level];
+
+            LLGL::TextureRegion region;
+            region.subresource.baseMipLevel = level;
+            region.subresource.numMipLevels = 1;
+            region.extent = {width, height, 1u};
+            renderer->WriteTexture(*texture, region, imageDesc);
+
+            width = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+
+        return texture;
+    }
+
+    bool supportsCompression(LLGL::RenderSystem *renderer) {
+        auto const &formats = renderer->GetRenderingCaps().textureFormats;
+        for (auto format : {LLGL::Format::BC1UNorm, LLGL::Format::BC3UNorm,
+                LLGL::Format::BC4UNorm, LLGL::Format::BC5UNorm}) {
+            if (std::find(formats.begin(), formats.end(), format) == formats.end()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     LLGL::Sampler *createSampler(LLGL::RenderSystem *renderer) {
         LLGL::SamplerDescriptor samplerInfo = {};
         samplerInfo.magFilter = LLGL::SamplerFilter::Linear;
@@ -46,14 +132,17 @@ namespace rise::rendering {
     }
 
     LLGL::ShaderProgram *createShaderProgram(LLGL::RenderSystem *renderer, std::string const &root,
-            LLGL::VertexFormat const &format) {
+            std::vector<LLGL::VertexFormat> const &formats) {
 
         std::string vertPath = root + "/shader.vert.spv";
         LLGL::ShaderProgramDescriptor programDesc;
 
         if (std::filesystem::exists(vertPath)) {
             auto desc = LLGL::ShaderDescFromFile(LLGL::ShaderType::Vertex, vertPath.data());
-            desc.vertex.inputAttribs = format.attributes;
+            for (auto const &format : formats) {
+                desc.vertex.inputAttribs.insert(desc.vertex.inputAttribs.end(),
+                        format.attributes.begin(), format.attributes.end());
+            }
             programDesc.vertexShader = renderer->CreateShader(desc);
         }
 
@@ -81,4 +170,43 @@ namespace rise::rendering {
 
         return renderer->CreateShaderProgram(programDesc);
     }
+
+    LLGL::ShaderProgram *reloadShaderProgram(LLGL::RenderSystem *renderer,
+            std::string const &root, std::vector<LLGL::VertexFormat> const &formats) {
+        auto program = createShaderProgram(renderer, root, formats);
+        if (program && !program->HasErrors()) {
+            return program;
+        }
+
+        std::cerr << "shader reload failed: " << root << std::endl;
+        if (program) {
+            std::string log = program->GetReport();
+            if (!log.empty()) {
+                std::cerr << log << std::endl;
+            }
+            renderer->Release(*program);
+        }
+        return nullptr;
+    }
+
+    std::vector<std::string> shaderFiles(std::string const &root) {
+        return {normalizePath(root + "/shader.vert.spv"),
+                normalizePath(root + "/shader.frag.spv"),
+                normalizePath(root + "/shader.geom.spv")};
+    }
+
+    void watchShaders(FileWatcher &watcher, std::string const &root) {
+        for (auto const &file : shaderFiles(root)) {
+            watcher.watch(file);
+        }
+    }
+
+    bool shadersChanged(std::vector<std::string> const &changed, std::string const &root) {
+        for (auto const &file : shaderFiles(root)) {
+            if (std::find(changed.begin(), changed.end(), file) != changed.end()) {
+                return true;
+            }
+        }
+        return false;
+    }
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include <LLGL/LLGL.h>
+#include "image.hpp"
+#include "watcher.hpp"
 
 namespace rise::rendering {
     template<typename T>
@@ -35,22 +37,34 @@ namespace rise::rendering {
     LLGL::Texture *createTextureFromData(LLGL::RenderSystem *renderer, LLGL::ImageFormat format,
             void const *data, unsigned width, unsigned height);
 
+    // создаёт текстуру со всеми mip уровнями из data в её формате
+    LLGL::Texture *createTexture(LLGL::RenderSystem *renderer, TextureData const &data);
+
+    // поддерживает ли устройство BC1, BC3, BC4 и BC5
+    bool supportsCompression(LLGL::RenderSystem *renderer);
+
     LLGL::Sampler *createSampler(LLGL::RenderSystem *renderer);
 
     template<typename T>
     LLGL::Buffer *createVertexBuffer(LLGL::RenderSystem *renderer, LLGL::VertexFormat const &format,
-            std::vector<T> const &data) {
+            T const *data, size_t count) {
         LLGL::VertexFormat vertexFormat = format;
         LLGL::BufferDescriptor VBufferDesc;
-        VBufferDesc.size = sizeof(T) * data.size();
+        VBufferDesc.size = sizeof(T) * count;
         VBufferDesc.bindFlags = LLGL::BindFlags::VertexBuffer;
         VBufferDesc.vertexAttribs = vertexFormat.attributes;
 
-        return renderer->CreateBuffer(VBufferDesc, data.data());
+        return renderer->CreateBuffer(VBufferDesc, data);
     }
 
     template<typename T>
-    LLGL::Buffer *createIndexBuffer(LLGL::RenderSystem *renderer, std::vector<T> const &data) {
+    LLGL::Buffer *createVertexBuffer(LLGL::RenderSystem *renderer, LLGL::VertexFormat const &format,
+            std::vector<T> const &data) {
+        return createVertexBuffer(renderer, format, data.data(), data.size());
+    }
+
+    template<typename T>
+    LLGL::Buffer *createIndexBuffer(LLGL::RenderSystem *renderer, T const *data, size_t count) {
         LLGL::Format format = LLGL::Format::Undefined;
         if constexpr(sizeof(T) == sizeof(uint32_t)) {
             format = LLGL::Format::R32UInt;
@@ -61,13 +75,28 @@ namespace rise::rendering {
         }
 
         LLGL::BufferDescriptor IBufferDesc;
-        IBufferDesc.size = sizeof(T) * data.size();
+        IBufferDesc.size = sizeof(T) * count;
         IBufferDesc.bindFlags = LLGL::BindFlags::IndexBuffer;
         IBufferDesc.format = format;
 
-        return renderer->CreateBuffer(IBufferDesc, data.data());
+        return renderer->CreateBuffer(IBufferDesc, data);
+    }
+
+    template<typename T>
+    LLGL::Buffer *createIndexBuffer(LLGL::RenderSystem *renderer, std::vector<T> const &data) {
+        return createIndexBuffer(renderer, data.data(), data.size());
     }
 
     LLGL::ShaderProgram *createShaderProgram(LLGL::RenderSystem *renderer, std::string const &root,
-            LLGL::VertexFormat const &format);
+            std::vector<LLGL::VertexFormat> const &formats);
+
+    // программа для горячей перезагрузки: при ошибках сборки печатает отчёт, освобождает
+    // новую программу и возвращает nullptr, чтобы вызывающий оставил прежнюю
+    LLGL::ShaderProgram *reloadShaderProgram(LLGL::RenderSystem *renderer,
+            std::string const &root, std::vector<LLGL::VertexFormat> const &formats);
+
+    // наблюдение за файлами, из которых createShaderProgram собирает программу
+    void watchShaders(FileWatcher &watcher, std::string const &root);
+
+    bool shadersChanged(std::vector<std::string> const &changed, std::string const &root);
 }
@@ -62,7 +62,7 @@ namespace rise::rendering {
             std::tuple init{
                     state,
                     UpdatedViewportState{},
-                    std::set<flecs::entity_t>{}
+                    ModelLinks{}
             };
 
             id.id = getApp(e)->manager.viewport.states.push_back(std::move(init));
@@ -83,11 +83,13 @@ namespace rise::rendering {
 
     void catchCameraUpdate(flecs::entity, ApplicationRef app, ViewportId viewport) {
         auto &manager = app.ref->id->manager;
+        std::lock_guard lock(manager.viewport.updatedMutex);
         std::get<eViewportUpdated>(manager.viewport.states.at(viewport.id)).get().camera = true;
     }
 
     void catchLightUpdate(flecs::entity, ApplicationRef app, ViewportRef viewport) {
         auto &manager = app.ref->id->manager;
+        std::lock_guard lock(manager.viewport.updatedMutex);
         std::get<eViewportUpdated>(manager.viewport.states.at(viewport.ref->id)).get().light = true;
     }
 
@@ -117,6 +119,8 @@ namespace rise::rendering {
                         size.width / size.height, 0.1f, farPlane);
                 viewport.pData->farPlane = farPlane;
                 viewport.pData->viewPos = toGlm(position);
+                viewport.frustum = extractFrustum(
+                        viewport.pData->projection * viewport.pData->view);
             } else {
                 std::cerr << "extent must not be null" << std::endl;
             }
@@ -134,6 +138,8 @@ namespace rise::rendering {
         if (updated.currentLight < scenePipeline::maxLightCount) {
             auto &lightState = std::get<eLightState>(manager.light.states.at(lightId.id)).get();
             lightState.id = updated.currentLight++;
+            lightState.position = toGlm(position);
+            lightState.distance = distance.meters;
             auto &light = viewport.pData->pointLights[lightState.id];
             light.position = toGlm(position);
             light.diffuse = toGlm(color);
@@ -0,0 +1,114 @@
+#include "watcher.hpp"
+#include <filesystem>
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#define RISE_FILE_WATCHER_INOTIFY
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace rise::rendering {
+    FileWatcher::~FileWatcher() {
+#ifdef RISE_FILE_WATCHER_INOTIFY
+        if (mThread.joinable()) {
+            char stop = 0;
+            [[maybe_unused]] auto written = write(mWake[1], &stop, 1);
+            mThread.join();
+        }
+
+        for (int fd : {mFd, mWake[0], mWake[1]}) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    void FileWatcher::watch(std::string const &file) {
+#ifdef RISE_FILE_WATCHER_INOTIFY
+        std::lock_guard lock(mMutex);
+        if (!mFiles.insert(file).second) {
+            return;
+        }
+
+        if (mFd < 0) {
+            mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (mFd < 0) {
+                std::cerr << "failed to init file watcher: " << std::strerror(errno) << std::endl;
+                mFiles.erase(file);
+                return;
+            }
+            if (pipe(mWake) != 0) {
+                std::cerr << "failed to init file watcher: " << std::strerror(errno) << std::endl;
+                close(mFd);
+                mFd = -1;
+                mFiles.erase(file);
+                return;
+            }
+            mThread = std::thread(&FileWatcher::work, this);
+        }
+
+        // редакторы часто пишут во временный файл и переименовывают его, поэтому
+        // наблюдаем за каталогом, а не за самим файлом
+        auto directory = std::filesystem::path(file).parent_path().string();
+        int wd = inotify_add_watch(mFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) {
+            mDirectories[wd] = directory;
+        }
+#endif
+    }
+
+    bool FileWatcher::poll(std::vector<std::string> &changed) {
+        if (!mDirty.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        std::lock_guard lock(mMutex);
+        mDirty.store(false, std::memory_order_relaxed);
+        changed.assign(mChanged.begin(), mChanged.end());
+        mChanged.clear();
+        return !changed.empty();
+    }
+
+    void FileWatcher::work() {
+#ifdef RISE_FILE_WATCHER_INOTIFY
+        alignas(inotify_event) char buffer[16 * 1024];
+        pollfd fds[] = {{mFd, POLLIN, 0}, {mWake[0], POLLIN, 0}};
+
+        while (true) {
+            if (::poll(fds, 2, -1) < 0) {
+                continue;
+            }
+            if (fds[1].revents) {
+                return;
+            }
+
+            auto size = read(mFd, buffer, sizeof(buffer));
+            if (size <= 0) {
+                continue;
+            }
+
+            std::lock_guard lock(mMutex);
+            for (char *p = buffer; p < buffer + size;) {
+                auto event = reinterpret_cast<inotify_event *>(p);
+                p += sizeof(inotify_event) + event->len;
+
+                auto directory = mDirectories.find(event->wd);
+                if (event->len == 0 || directory == mDirectories.end()) {
+                    continue;
+                }
+
+                auto file = directory->second + "/" + event->name;
+                if (mFiles.count(file)) {
+                    mChanged.insert(std::move(file));
+                    mDirty.store(true, std::memory_order_release);
+                }
+            }
+        }
+#endif
+    }
+}
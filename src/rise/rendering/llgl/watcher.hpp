@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+namespace rise::rendering {
+    // следит за файлами ресурсов через inotify в отдельном потоке. Изменения между кадрами
+    // собираются в один набор без повторов, кадр без изменений проверяет только флаг
+    class FileWatcher {
+    public:
+        FileWatcher() = default;
+
+        FileWatcher(FileWatcher const &) = delete;
+
+        FileWatcher &operator=(FileWatcher const &) = delete;
+
+        ~FileWatcher();
+
+        // file - нормализованный путь, файл может ещё не существовать
+        void watch(std::string const &file);
+
+        // изменённые с прошлого вызова файлы, false если изменений нет
+        bool poll(std::vector<std::string> &changed);
+
+    private:
+        void work();
+
+        std::mutex mMutex;
+        std::set<std::string> mFiles;
+        std::set<std::string> mChanged;
+        std::map<int, std::string> mDirectories;
+        std::atomic<bool> mDirty = false;
+        std::thread mThread;
+        int mFd = -1;
+        int mWake[2] = {-1, -1};
+    };
+}
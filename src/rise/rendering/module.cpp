@@ -1,5 +1,6 @@
 #include "module.hpp"
 #include "imgui.hpp"
+#include "glm.hpp"
 
 namespace rise::rendering {
     using namespace rendering;
@@ -12,6 +13,7 @@ namespace rise::rendering {
         ecs.component<Extent2D>("Extent2D");
         ecs.component<Position3D>("Position3D");
         ecs.component<Rotation3D>("Rotation3D");
+        ecs.component<Orientation3D>("Orientation3D");
         ecs.component<Scale3D>("Scale3D");
         ecs.component<Extent3D>("Extent3D");
         ecs.component<DiffuseColor>("DiffuseColor");
@@ -24,10 +26,11 @@ namespace rise::rendering {
         ecs.component<Path>("Path");
         ecs.component<Relative>("Relative");
         ecs.component<Title>("Title");
+        ecs.component<Threads>("Threads");
+        ecs.component<JobSystemId>("JobSystemId");
         ecs.component<AlbedoTexture>("AlbedoTexture");
-        ecs.component<MetallicTexture>("MetallicTexture");
-        ecs.component<AoTexture>("AoTexture");
-        ecs.component<RoughnessTexture>("RoughnessTexture");
+        ecs.component<PackedOrmTexture>("PackedOrmTexture");
+        ecs.component<OrmPath>("OrmPath");
         ecs.component<GuiContext>("GuiContext");
         ecs.component<Mesh>("Mesh");
         ecs.component<Texture>("Texture");
@@ -38,5 +41,31 @@ namespace rise::rendering {
         ecs.component<Viewport>("Viewport");
         ecs.component<RegTo>("RegTo");
         ecs.component<RenderTo>("RenderTo");
+        ecs.component<MainThreadSystems>("MainThreadSystems");
+        ecs.set<MainThreadSystems>({});
+
+        // камера хранит в Rotation3D углы обзора, а не поворот
+        ecs.system<const Rotation3D>("syncOrientation", "!Viewport").kind(flecs::OnSet).each(
+                [](flecs::entity e, Rotation3D rotation) {
+                    e.set<Orientation3D>(fromGlmOrientation3D(rotationToQuat(rotation)));
+                });
+    }
+
+    void runMainThread(flecs::world &ecs, flecs::entity_t phase) {
+        auto delta = ecs.delta_time();
+        for (auto[systemPhase, system] : ecs.get<MainThreadSystems>()->systems) {
+            if (systemPhase == phase) {
+                ecs_run(ecs.c_ptr(), system, delta, nullptr);
+            }
+        }
+    }
+
+    bool progress(flecs::world &ecs) {
+        runMainThread(ecs, flecs::OnLoad);
+        runMainThread(ecs, flecs::PostLoad);
+        bool running = ecs.progress();
+        runMainThread(ecs, flecs::PreStore);
+        runMainThread(ecs, flecs::OnStore);
+        return running;
     }
-}
\ No newline at end of file
+}
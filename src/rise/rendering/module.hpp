@@ -3,6 +3,11 @@
 #include <flecs.h>
 #include <string>
 #include <memory>
+#include <vector>
+
+namespace rise {
+    class JobSystem;
+}
 
 namespace rise::rendering {
     struct Position2D {
@@ -37,6 +42,15 @@ namespace rise::rendering {
         float z;
     };
 
+    // ориентация кватернионом, используется рендерингом и физикой. Rotation3D - её
+    // представление для редактора, при изменении переводится в Orientation3D
+    struct Orientation3D {
+        float x;
+        float y;
+        float z;
+        float w;
+    };
+
     struct Scale3D {
         float x;
         float y;
@@ -89,6 +103,18 @@ namespace rise::rendering {
         std::string title;
     };
 
+    // потоки приложения вместе с главным: пул задач рендера получает count - 1 рабочих, и то
+    // же число стоит передать ecs.set_threads. Конвейер flecs и parallelFor систем главного
+    // потока не выполняются одновременно, так что пулы делят одни ядра, а не соперничают
+    struct Threads {
+        unsigned count;
+    };
+
+    // пул задач приложения для модулей, которым не нужен остальной ApplicationState
+    struct JobSystemId {
+        JobSystem *id;
+    };
+
     struct Relative {
         bool enabled;
     };
@@ -97,16 +123,16 @@ namespace rise::rendering {
         flecs::entity e;
     };
 
-    struct MetallicTexture {
+    // текстура, в каналах которой упакованы ao, roughness и metallic
+    struct PackedOrmTexture {
         flecs::entity e;
     };
 
-    struct RoughnessTexture {
-        flecs::entity e;
-    };
-
-    struct AoTexture {
-        flecs::entity e;
+    // одноканальные карты, которые при загрузке упаковываются в одну текстуру
+    struct OrmPath {
+        std::string ao;
+        std::string roughness;
+        std::string metallic;
     };
 
     struct RegTo {
@@ -131,6 +157,29 @@ namespace rise::rendering {
 
     struct Shadow {};
 
+    // системы, которые обращаются к SDL, LLGL, ImGui или очередям ApplicationState. Они не
+    // входят в конвейер flecs и запускаются progress() с главного потока, поэтому
+    // ecs.set_threads() распределяет по рабочим потокам только остальные системы. Счётную
+    // работу внутри таких систем разбивает JobSystem. OnSet системы на компоненты, которые
+    // пишет конвейер (трансформации, материалы, свет, скорость и масса тел), могут
+    // выполняться на рабочих потоках и только ставят изменения в очереди под мьютексом
+    struct MainThreadSystems {
+        std::vector<std::pair<flecs::entity_t, flecs::entity_t>> systems;
+    };
+
+    // создаёт систему builder без фазы и запоминает её для запуска в фазе phase
+    template<typename Builder, typename F>
+    flecs::entity_t mainThreadSystem(flecs::world &ecs, flecs::entity_t phase, Builder &&builder,
+            F &&f) {
+        auto id = builder.kind(0).each(std::forward<F>(f)).id();
+        ecs.get_mut<MainThreadSystems>()->systems.emplace_back(phase, id);
+        return id;
+    }
+
+    // кадр: OnLoad и PostLoad главного потока, конвейер flecs (на рабочих потоках, если они
+    // заданы), затем PreStore и OnStore главного потока
+    bool progress(flecs::world &ecs);
+
     struct Module {
         explicit Module(flecs::world &ecs);
     };
@@ -0,0 +1,31 @@
+#include "queue.hpp"
+#include <array>
+
+namespace rise::rendering {
+    void radixSort(std::vector<SortItem> &items, std::vector<SortItem> &scratch) {
+        scratch.resize(items.size());
+
+        for (unsigned shift = 0; shift != 64; shift += 8) {
+            std::array<uint32_t, 256> offsets{};
+            for (auto const &item : items) {
+                ++offsets[(item.key >> shift) & 0xff];
+            }
+
+            if (offsets[(items.front().key >> shift) & 0xff] == items.size()) {
+                continue;
+            }
+
+            uint32_t sum = 0;
+            for (auto &offset : offsets) {
+                auto count = offset;
+                offset = sum;
+                sum += count;
+            }
+
+            for (auto const &item : items) {
+                scratch[offsets[(item.key >> shift) & 0xff]++] = item;
+            }
+            items.swap(scratch);
+        }
+    }
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cassert>
+
+namespace rise::rendering {
+    // 64-битный ключ сортировки: pipeline(8) | heap(20) | mesh(20) | depth(16). Номер,
+    // не поместившийся в своё поле, прижимается к наибольшему значению поля: такие пакеты
+    // хуже группируются, но состояние в flush берётся по полным номерам, а не из ключа
+    namespace sortKey {
+        const unsigned depthBits = 16;
+        const unsigned meshBits = 20;
+        const unsigned heapBits = 20;
+        const unsigned pipelineBits = 8;
+
+        const unsigned meshShift = depthBits;
+        const unsigned heapShift = meshShift + meshBits;
+        const unsigned pipelineShift = heapShift + heapBits;
+
+        const uint32_t maxPipeline = (1u << pipelineBits) - 1;
+        const uint32_t maxHeap = (1u << heapBits) - 1;
+        const uint32_t maxMesh = (1u << meshBits) - 1;
+
+        inline bool fits(uint32_t pipeline, uint32_t heap, uint32_t mesh) {
+            return pipeline <= maxPipeline && heap <= maxHeap && mesh <= maxMesh;
+        }
+
+        inline uint64_t make(uint32_t pipeline, uint32_t heap, uint32_t mesh, uint16_t depth) {
+            return (uint64_t(std::min(pipeline, maxPipeline)) << pipelineShift) |
+                    (uint64_t(std::min(heap, maxHeap)) << heapShift) |
+                    (uint64_t(std::min(mesh, maxMesh)) << meshShift) |
+                    uint64_t(depth);
+        }
+
+        inline uint32_t pipeline(uint64_t key) {
+            return uint32_t(key >> pipelineShift) & ((1u << pipelineBits) - 1);
+        }
+
+        inline uint32_t heap(uint64_t key) {
+            return uint32_t(key >> heapShift) & ((1u << heapBits) - 1);
+        }
+
+        inline uint32_t mesh(uint64_t key) {
+            return uint32_t(key >> meshShift) & ((1u << meshBits) - 1);
+        }
+
+        inline uint16_t depth(float distance, float farPlane) {
+            float normalized = std::clamp(distance / farPlane, 0.0f, 1.0f);
+            return static_cast<uint16_t>(normalized * float((1u << depthBits) - 1));
+        }
+    }
+
+    struct SortItem {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // LSD radix sort по байтам ключа, проходы с одинаковым байтом у всех элементов пропускаются
+    void radixSort(std::vector<SortItem> &items, std::vector<SortItem> &scratch);
+
+    struct RenderQueueStats {
+        uint32_t packets = 0;
+        uint32_t pipelineChanges = 0;
+        uint32_t heapChanges = 0;
+        uint32_t meshChanges = 0;
+        uint32_t removedChanges = 0;
+        uint32_t draws = 0;
+        uint32_t instances = 0;
+        // пакеты, номера состояний которых не поместились в ключ сортировки
+        uint32_t keyOverflows = 0;
+    };
+
+    // сопоставляет состояниям бэкенда компактные номера для ключа сортировки на один кадр.
+    // Номера идут подряд с нуля, о переполнении полей ключа заботится RenderQueue
+    template<typename T>
+    class HandleTable {
+    public:
+        uint32_t get(T const &val) {
+            auto it = mHandles.try_emplace(val, static_cast<uint32_t>(mValues.size()));
+            if (it.second) {
+                mValues.push_back(val);
+            }
+            return it.first->second;
+        }
+
+        T const &operator[](uint32_t handle) const {
+            assert(handle < mValues.size() && "Unknown handle");
+            return mValues[handle];
+        }
+
+        size_t size() const {
+            return mValues.size();
+        }
+
+        void clear() {
+            mHandles.clear();
+            mValues.clear();
+        }
+
+    private:
+        std::map<T, uint32_t> mHandles;
+        std::vector<T> mValues;
+    };
+
+    // очередь отрисовки: системы кладут пакеты с ключом, затем очередь сортирует их и выдаёт
+    // команды в бэкенд, пропуская повторную установку одного и того же состояния
+    template<typename Packet>
+    class RenderQueue {
+    public:
+        void push(uint32_t pipeline, uint32_t heap, uint32_t mesh, uint16_t depth,
+                Packet const &packet) {
+            if (!sortKey::fits(pipeline, heap, mesh)) {
+                ++mKeyOverflows;
+            }
+            mItems.push_back({sortKey::make(pipeline, heap, mesh, depth),
+                    static_cast<uint32_t>(mPackets.size())});
+            mStates.push_back({pipeline, heap, mesh});
+            mPackets.push_back(packet);
+        }
+
+        size_t size() const {
+            return mPackets.size();
+        }
+
+        void sort() {
+            if (!mItems.empty()) {
+                radixSort(mItems, mScratch);
+            }
+
+            mSorted.clear();
+            mSorted.reserve(mItems.size());
+            for (auto const &item : mItems) {
+                mSorted.push_back(mPackets[item.index]);
+            }
+        }
+
+        // Emitter: pipeline(handle), heap(handle, packet), mesh(handle, packet),
+        // draw(packets, count) - пакеты с одинаковыми pipeline, heap и mesh идут одним диапазоном
+        template<typename Emitter>
+        void flush(Emitter &&emitter, RenderQueueStats &stats) {
+            const uint32_t none = ~0u;
+            uint32_t pipeline = none;
+            uint32_t heap = none;
+            uint32_t mesh = none;
+            uint32_t changes = 0;
+
+            size_t i = 0;
+            while (i != mItems.size()) {
+                auto const &state = mStates[mItems[i].index];
+                auto p = state.pipeline;
+                auto h = state.heap;
+                auto m = state.mesh;
+
+                if (p != pipeline) {
+                    emitter.pipeline(p);
+                    pipeline = p;
+                    heap = none;
+                    mesh = none;
+                    ++stats.pipelineChanges;
+                    ++changes;
+                }
+
+                if (h != heap) {
+                    emitter.heap(h, mSorted[i]);
+                    heap = h;
+                    ++stats.heapChanges;
+                    ++changes;
+                }
+
+                if (m != mesh) {
+                    emitter.mesh(m, mSorted[i]);
+                    mesh = m;
+                    ++stats.meshChanges;
+                    ++changes;
+                }
+
+                size_t end = i + 1;
+                while (end != mItems.size() && mStates[mItems[end].index] == state) {
+                    ++end;
+                }
+
+                emitter.draw(mSorted.data() + i, end - i);
+                i = end;
+            }
+
+            auto packets = static_cast<uint32_t>(mItems.size());
+            stats.packets += packets;
+            stats.removedChanges += packets * 3 - changes;
+            stats.keyOverflows += mKeyOverflows;
+        }
+
+        void clear() {
+            mItems.clear();
+            mStates.clear();
+            mPackets.clear();
+            mSorted.clear();
+            mKeyOverflows = 0;
+        }
+
+    private:
+        struct State {
+            uint32_t pipeline;
+            uint32_t heap;
+            uint32_t mesh;
+
+            bool operator==(State const &other) const {
+                return pipeline == other.pipeline && heap == other.heap && mesh == other.mesh;
+            }
+        };
+
+        std::vector<SortItem> mItems;
+        std::vector<SortItem> mScratch;
+        std::vector<State> mStates;
+        std::vector<Packet> mPackets;
+        std::vector<Packet> mSorted;
+        uint32_t mKeyOverflows = 0;
+    };
+}
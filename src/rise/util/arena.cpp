@@ -0,0 +1,35 @@
+#include "arena.hpp"
+#include <algorithm>
+
+namespace rise {
+    FrameArena::FrameArena(size_t blockSize) {
+        mBlocks.push_back({std::make_unique<std::byte[]>(blockSize), blockSize});
+    }
+
+    void *FrameArena::allocateBlock(size_t size, size_t alignment) {
+        ++mStats.blocks;
+        size_t blockSize = std::max(mBlocks.back().size * 2, size + alignment);
+        mBlocks.push_back({std::make_unique<std::byte[]>(blockSize), blockSize});
+
+        size_t offset = alignedOffset(mBlocks.back().data.get(), 0, alignment);
+        mOffset = offset + size;
+        return mBlocks.back().data.get() + offset;
+    }
+
+    void FrameArena::reset() {
+        if (onReset) {
+            onReset(mStats);
+        }
+        mStats = {};
+        mOffset = 0;
+
+        if (mBlocks.size() > 1) {
+            size_t total = 0;
+            for (auto const &block : mBlocks) {
+                total += block.size;
+            }
+            mBlocks.clear();
+            mBlocks.push_back({std::make_unique<std::byte[]>(total), total});
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace rise {
+    struct AllocationStats {
+        // выделения из арены за кадр
+        uint32_t allocations = 0;
+        size_t bytes = 0;
+        // обращения арены к системному аллокатору за новыми блоками
+        uint32_t blocks = 0;
+    };
+
+    // линейный аллокатор на кадр: выделение - сдвиг указателя, освобождения по одному нет,
+    // reset() разом возвращает всю память. Если кадру не хватило блока, при сбросе блоки
+    // сливаются в один общего размера, и следующие кадры обходятся без системного аллокатора
+    class FrameArena {
+    public:
+        explicit FrameArena(size_t blockSize = 64 * 1024);
+
+        FrameArena(FrameArena const &) = delete;
+
+        FrameArena &operator=(FrameArena const &) = delete;
+
+        void *allocate(size_t size, size_t alignment) {
+            ++mStats.allocations;
+            mStats.bytes += size;
+
+            auto &block = mBlocks.back();
+            size_t offset = alignedOffset(block.data.get(), mOffset, alignment);
+            if (offset + size > block.size) {
+                return allocateBlock(size, alignment);
+            }
+            mOffset = offset + size;
+            return block.data.get() + offset;
+        }
+
+        // память всех выделений кадра становится недействительной
+        void reset();
+
+        AllocationStats const &stats() const {
+            return mStats;
+        }
+
+        // вызывается в reset() со статистикой завершившегося кадра
+        std::function<void(AllocationStats const &)> onReset;
+
+    private:
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            size_t size = 0;
+        };
+
+        // выравнивается адрес, а не смещение: new[] для std::byte гарантирует
+        // только выравнивание по умолчанию
+        static size_t alignedOffset(std::byte *data, size_t offset, size_t alignment) {
+            auto base = reinterpret_cast<uintptr_t>(data);
+            return ((base + offset + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+        }
+
+        void *allocateBlock(size_t size, size_t alignment);
+
+        std::vector<Block> mBlocks;
+        size_t mOffset = 0;
+        AllocationStats mStats;
+    };
+
+    // аллокатор контейнеров поверх FrameArena. Без арены работает через обычный new/delete,
+    // поэтому контейнер можно создать до того, как известна арена
+    template<typename T>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        ArenaAllocator() = default;
+
+        explicit ArenaAllocator(FrameArena *arena) : mArena(arena) {}
+
+        template<typename U>
+        ArenaAllocator(ArenaAllocator<U> const &other) : mArena(other.arena()) {}
+
+        T *allocate(size_t count) {
+            if (mArena) {
+                return static_cast<T *>(mArena->allocate(count * sizeof(T), alignof(T)));
+            }
+            return std::allocator<T>{}.allocate(count);
+        }
+
+        void deallocate(T *pointer, size_t count) {
+            if (!mArena) {
+                std::allocator<T>{}.deallocate(pointer, count);
+            }
+        }
+
+        FrameArena *arena() const {
+            return mArena;
+        }
+
+        template<typename U>
+        bool operator==(ArenaAllocator<U> const &other) const {
+            return mArena == other.arena();
+        }
+
+        template<typename U>
+        bool operator!=(ArenaAllocator<U> const &other) const {
+            return mArena != other.arena();
+        }
+
+    private:
+        FrameArena *mArena = nullptr;
+    };
+
+    // очередь команд на кадр: память берётся из арены и отдаётся при её сбросе
+    template<typename T>
+    using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+    template<typename T>
+    void attach(FrameVector<T> &queue, FrameArena &arena) {
+        queue = FrameVector<T>(ArenaAllocator<T>(&arena));
+    }
+
+    // clear() оставил бы за вектором буфер, который после reset() арены займут другие
+    template<typename T>
+    void release(FrameVector<T> &queue) {
+        FrameVector<T>(queue.get_allocator()).swap(queue);
+    }
+}
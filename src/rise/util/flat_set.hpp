@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+namespace rise {
+    // множество на отсортированном векторе: элементы лежат подряд, обход без переходов по
+    // узлам дерева, вставка и удаление - бинарный поиск и сдвиг хвоста
+    template<typename T>
+    class FlatSet {
+    public:
+        using value_type = T;
+        using const_iterator = typename std::vector<T>::const_iterator;
+
+        bool insert(T const &value) {
+            auto it = std::lower_bound(mValues.begin(), mValues.end(), value);
+            if (it != mValues.end() && *it == value) {
+                return false;
+            }
+            mValues.insert(it, value);
+            return true;
+        }
+
+        bool erase(T const &value) {
+            auto it = std::lower_bound(mValues.begin(), mValues.end(), value);
+            if (it == mValues.end() || *it != value) {
+                return false;
+            }
+            mValues.erase(it);
+            return true;
+        }
+
+        bool contains(T const &value) const {
+            return std::binary_search(mValues.begin(), mValues.end(), value);
+        }
+
+        const_iterator begin() const { return mValues.begin(); }
+
+        const_iterator end() const { return mValues.end(); }
+
+        size_t size() const { return mValues.size(); }
+
+        bool empty() const { return mValues.empty(); }
+
+        void clear() { mValues.clear(); }
+
+    private:
+        std::vector<T> mValues;
+    };
+}
@@ -1,53 +1,321 @@
 #include "flecs_os.hpp"
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <memory>
 #include <flecs.h>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* flecs threads are served by a persistent pool: thread_new hands the callback
+ * to an idle worker (starting a new one only when all are busy) and
+ * thread_join waits for it and returns the worker to the pool, so changing
+ * set_threads() at runtime does not create and destroy OS threads. */
+struct stdcpp_worker {
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable finished;
+  ecs_os_thread_callback_t callback = nullptr;
+  void* arg = nullptr;
+  void* result = nullptr;
+  bool busy = false;
+  bool done = false;
+  bool quit = false;
+};
+
+struct stdcpp_thread_pool {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<stdcpp_worker>> workers;
+  bool pin = false;
+
+  ~stdcpp_thread_pool() {
+    for (auto& worker : workers) {
+      {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->quit = true;
+      }
+      worker->wake.notify_one();
+      worker->thread.join();
+    }
+  }
+};
+
+static stdcpp_thread_pool stdcpp_pool;
+
+static
+void stdcpp_worker_run(stdcpp_worker* worker) {
+  std::unique_lock<std::mutex> lock(worker->mutex);
+  for (;;) {
+    worker->wake.wait(lock, [worker] {
+      return worker->quit || (worker->callback && !worker->done);
+    });
+    if (worker->quit) {
+      return;
+    }
+
+    ecs_os_thread_callback_t callback = worker->callback;
+    void* arg = worker->arg;
+    lock.unlock();
+    void* result = callback(arg);
+    lock.lock();
+
+    worker->result = result;
+    worker->done = true;
+    worker->finished.notify_one();
+  }
+}
+
+/* Names the worker for perf/top and, if requested, pins it to one core. */
+static
+void stdcpp_worker_setup(stdcpp_worker* worker, size_t index, bool pin) {
+#if defined(__linux__)
+  char name[16];
+  snprintf(name, sizeof(name), "rise-flecs-%zu", index);
+  pthread_setname_np(worker->thread.native_handle(), name);
+
+  unsigned cores = std::thread::hardware_concurrency();
+  if (pin && cores) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cores, &set);
+    pthread_setaffinity_np(worker->thread.native_handle(), sizeof(set), &set);
+  }
+#else
+  (void)worker;
+  (void)index;
+  (void)pin;
+#endif
+}
+
 static
 ecs_os_thread_t stdcpp_thread_new(
   ecs_os_thread_callback_t callback,
   void* arg)
 {
-  std::thread* thread = new std::thread{ callback,arg };
-  return reinterpret_cast<ecs_os_thread_t>(thread);
+  std::lock_guard<std::mutex> pool_lock(stdcpp_pool.mutex);
+
+  stdcpp_worker* worker = nullptr;
+  for (auto& candidate : stdcpp_pool.workers) {
+    if (!candidate->busy) {
+      worker = candidate.get();
+      break;
+    }
+  }
+
+  if (!worker) {
+    stdcpp_pool.workers.push_back(std::make_unique<stdcpp_worker>());
+    worker = stdcpp_pool.workers.back().get();
+    worker->thread = std::thread{ stdcpp_worker_run, worker };
+    stdcpp_worker_setup(worker, stdcpp_pool.workers.size() - 1, stdcpp_pool.pin);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->busy = true;
+    worker->done = false;
+    worker->callback = callback;
+    worker->arg = arg;
+  }
+  worker->wake.notify_one();
+  return reinterpret_cast<ecs_os_thread_t>(worker);
 }
 
 static
 void* stdcpp_thread_join(
   ecs_os_thread_t thread)
 {
-  void* arg = nullptr;
-  std::thread* thr = reinterpret_cast<std::thread*>(thread);
-  thr->join();
-  delete thr;
-  return arg;
+  stdcpp_worker* worker = reinterpret_cast<stdcpp_worker*>(thread);
+  void* result;
+  {
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    worker->finished.wait(lock, [worker] { return worker->done; });
+    result = worker->result;
+    worker->callback = nullptr;
+    worker->arg = nullptr;
+  }
+
+  std::lock_guard<std::mutex> pool_lock(stdcpp_pool.mutex);
+  worker->busy = false;
+  return result;
 }
 
+/* Counters are plain int32_t owned by flecs, so they are accessed through an
+ * atomic view instead of being replaced by std::atomic. */
 static
 int32_t stdcpp_ainc(int32_t* count) {
-  int value;
-#ifdef __GNUC__
-  value = __sync_add_and_fetch(count, 1);
-  return value;
+#if defined(__cpp_lib_atomic_ref)
+  return std::atomic_ref<int32_t>(*count).fetch_add(1) + 1;
+#elif defined(__GNUC__)
+  return __atomic_add_fetch(count, 1, __ATOMIC_SEQ_CST);
 #else
-  /* Unsupported */
-  abort();
+  return _InterlockedIncrement(reinterpret_cast<long volatile*>(count));
 #endif
 }
 
 static
 int32_t stdcpp_adec(int32_t* count) {
-  int value;
-#ifdef __GNUC__
-  value = __sync_sub_and_fetch(count, 1);
-  return value;
+#if defined(__cpp_lib_atomic_ref)
+  return std::atomic_ref<int32_t>(*count).fetch_sub(1) - 1;
+#elif defined(__GNUC__)
+  return __atomic_sub_fetch(count, 1, __ATOMIC_SEQ_CST);
 #else
-  /* Unsupported */
-  abort();
+  return _InterlockedDecrement(reinterpret_cast<long volatile*>(count));
+#endif
+}
+
+/* How many times lock() retries before it parks the thread. flecs workers hold
+ * their mutexes for a few instructions, so a short spin usually wins. */
+static int stdcpp_spin_count = 0;
+
+static
+void stdcpp_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
 #endif
 }
 
+#if defined(__linux__)
+
+/* Linux: mutex and condition variable are single futex words (Drepper,
+ * "Futexes Are Tricky"). Uncontended lock/unlock is one atomic operation and
+ * cond_wait needs no second internal mutex. */
+
+static
+void stdcpp_futex_wait(std::atomic<uint32_t>* word, uint32_t expected) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE,
+    expected, nullptr, nullptr, 0);
+}
+
+static
+void stdcpp_futex_wake(std::atomic<uint32_t>* word, int count) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE,
+    count, nullptr, nullptr, 0);
+}
+
+/* 0 - unlocked, 1 - locked, 2 - locked and someone may sleep on it */
+struct stdcpp_mutex {
+  alignas(64) std::atomic<uint32_t> state{0};
+};
+
+struct stdcpp_cond {
+  alignas(64) std::atomic<uint32_t> sequence{0};
+};
+
+static
+void stdcpp_mutex_lock_contended(stdcpp_mutex* mutex) {
+  while (mutex->state.exchange(2, std::memory_order_acquire) != 0) {
+    stdcpp_futex_wait(&mutex->state, 2);
+  }
+}
+
+static
+ecs_os_mutex_t stdcpp_mutex_new(void) {
+  stdcpp_mutex* mutex = new stdcpp_mutex;
+  return reinterpret_cast<ecs_os_mutex_t>(mutex);
+}
+
+static
+void stdcpp_mutex_free(ecs_os_mutex_t m) {
+  stdcpp_mutex* mutex = reinterpret_cast<stdcpp_mutex*>(m);
+  delete mutex;
+}
+
+static
+void stdcpp_mutex_lock(ecs_os_mutex_t m) {
+  stdcpp_mutex* mutex = reinterpret_cast<stdcpp_mutex*>(m);
+  uint32_t expected = 0;
+  if (mutex->state.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+    return;
+  }
+
+  for (int i = 0; i < stdcpp_spin_count; i++) {
+    stdcpp_cpu_relax();
+    expected = 0;
+    if (mutex->state.load(std::memory_order_relaxed) == 0 &&
+      mutex->state.compare_exchange_weak(expected, 1, std::memory_order_acquire)) {
+      return;
+    }
+  }
+
+  stdcpp_mutex_lock_contended(mutex);
+}
+
+static
+void stdcpp_mutex_unlock(ecs_os_mutex_t m) {
+  stdcpp_mutex* mutex = reinterpret_cast<stdcpp_mutex*>(m);
+  if (mutex->state.exchange(0, std::memory_order_release) == 2) {
+    stdcpp_futex_wake(&mutex->state, 1);
+  }
+}
+
+static
+ecs_os_cond_t stdcpp_cond_new(void) {
+  stdcpp_cond* cond = new stdcpp_cond;
+  return reinterpret_cast<ecs_os_cond_t>(cond);
+}
+
+static
+void stdcpp_cond_free(ecs_os_cond_t c) {
+  stdcpp_cond* cond = reinterpret_cast<stdcpp_cond*>(c);
+  delete cond;
+}
+
+static
+void stdcpp_cond_signal(ecs_os_cond_t c) {
+  stdcpp_cond* cond = reinterpret_cast<stdcpp_cond*>(c);
+  cond->sequence.fetch_add(1, std::memory_order_release);
+  stdcpp_futex_wake(&cond->sequence, 1);
+}
+
+static
+void stdcpp_cond_broadcast(ecs_os_cond_t c) {
+  stdcpp_cond* cond = reinterpret_cast<stdcpp_cond*>(c);
+  cond->sequence.fetch_add(1, std::memory_order_release);
+  stdcpp_futex_wake(&cond->sequence, INT32_MAX);
+}
+
+static
+void stdcpp_cond_wait(ecs_os_cond_t c, ecs_os_mutex_t m) {
+  stdcpp_cond* cond = reinterpret_cast<stdcpp_cond*>(c);
+  stdcpp_mutex* mutex = reinterpret_cast<stdcpp_mutex*>(m);
+
+  /* A signal between unlock and futex_wait changes the sequence, so the wait
+   * returns immediately instead of missing it. */
+  uint32_t sequence = cond->sequence.load(std::memory_order_relaxed);
+  stdcpp_mutex_unlock(m);
+  stdcpp_futex_wait(&cond->sequence, sequence);
+
+  /* Other waiters may have woken too, so the mutex is taken in the contended
+   * state to make sure the next unlock wakes one of them. */
+  stdcpp_mutex_lock_contended(mutex);
+}
+
+#else
+
+/* Other platforms: std::mutex with a plain std::condition_variable adopting
+ * it, which avoids the extra internal lock of condition_variable_any. */
+
 static
 ecs_os_mutex_t stdcpp_mutex_new(void) {
   std::mutex* mutex = new std::mutex;
@@ -63,6 +331,12 @@ void stdcpp_mutex_free(ecs_os_mutex_t m) {
 static
 void stdcpp_mutex_lock(ecs_os_mutex_t m) {
   std::mutex* mutex = reinterpret_cast<std::mutex*>(m);
+  for (int i = 0; i < stdcpp_spin_count; i++) {
+    if (mutex->try_lock()) {
+      return;
+    }
+    stdcpp_cpu_relax();
+  }
   mutex->lock();
 }
 
@@ -74,36 +348,42 @@ void stdcpp_mutex_unlock(ecs_os_mutex_t m) {
 
 static
 ecs_os_cond_t stdcpp_cond_new(void) {
-  std::condition_variable_any* cond = new std::condition_variable_any{};
-  return (ecs_os_cond_t)cond;
+  std::condition_variable* cond = new std::condition_variable{};
+  return reinterpret_cast<ecs_os_cond_t>(cond);
 }
 
 static
 void stdcpp_cond_free(ecs_os_cond_t c) {
-  std::condition_variable_any* cond = reinterpret_cast<std::condition_variable_any*>(c);
+  std::condition_variable* cond = reinterpret_cast<std::condition_variable*>(c);
   delete cond;
 }
 
 static
 void stdcpp_cond_signal(ecs_os_cond_t c) {
-  std::condition_variable_any* cond = reinterpret_cast<std::condition_variable_any*>(c);
+  std::condition_variable* cond = reinterpret_cast<std::condition_variable*>(c);
   cond->notify_one();
 }
 
 static
 void stdcpp_cond_broadcast(ecs_os_cond_t c) {
-  std::condition_variable_any* cond = reinterpret_cast<std::condition_variable_any*>(c);
+  std::condition_variable* cond = reinterpret_cast<std::condition_variable*>(c);
   cond->notify_all();
 }
 
 static
 void stdcpp_cond_wait(ecs_os_cond_t c, ecs_os_mutex_t m) {
-  std::condition_variable_any* cond = reinterpret_cast<std::condition_variable_any*>(c);
+  std::condition_variable* cond = reinterpret_cast<std::condition_variable*>(c);
   std::mutex* mutex = reinterpret_cast<std::mutex*>(m);
-  cond->wait(*mutex);
+  std::unique_lock<std::mutex> lock(*mutex, std::adopt_lock);
+  cond->wait(lock);
+  lock.release();
 }
 
-void stdcpp_set_os_api(void) {
+#endif
+
+void stdcpp_set_os_api(int spin_count, bool pin_threads) {
+  stdcpp_spin_count = spin_count;
+  stdcpp_pool.pin = pin_threads;
   ecs_os_set_api_defaults();
 
   ecs_os_api_t api = ecs_os_api;
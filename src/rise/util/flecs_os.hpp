@@ -1 +1,3 @@
-void stdcpp_set_os_api(void);
\ No newline at end of file
+/* spin_count - attempts to take a contended mutex before the thread is parked,
+ * 0 parks immediately. pin_threads - bind each flecs worker to its own core */
+void stdcpp_set_os_api(int spin_count = 100, bool pin_threads = false);
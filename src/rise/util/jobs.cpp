@@ -0,0 +1,243 @@
+#include "jobs.hpp"
+
+namespace rise {
+    struct Job {
+        std::function<void()> task;
+        JobCounter *counter = nullptr;
+    };
+
+    namespace {
+        thread_local JobSystem const *tSystem = nullptr;
+        thread_local int tIndex = -1;
+        thread_local uint32_t tSeed = 0x9e3779b9u;
+
+        uint32_t nextRandom() {
+            tSeed ^= tSeed << 13;
+            tSeed ^= tSeed >> 17;
+            tSeed ^= tSeed << 5;
+            return tSeed;
+        }
+
+        // перед засыпанием поток ещё немного ищет работу, чтобы не платить за пробуждение
+        constexpr int spinCount = 64;
+    }
+
+    bool JobDeque::push(Job *job) {
+        int64_t bottom = mBottom.load(std::memory_order_relaxed);
+        int64_t top = mTop.load(std::memory_order_acquire);
+        if (bottom - top >= capacity) {
+            return false;
+        }
+        mJobs[bottom & (capacity - 1)].store(job, std::memory_order_relaxed);
+        mBottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    Job *JobDeque::pop() {
+        int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+        // seq_cst запись bottom и чтение top вместо барьера между relaxed операциями: порядок
+        // с чтениями в steal задают сами атомарные операции, и его проверяет TSan
+        mBottom.store(bottom, std::memory_order_seq_cst);
+        int64_t top = mTop.load(std::memory_order_seq_cst);
+
+        if (top > bottom) {
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job *job = mJobs[bottom & (capacity - 1)].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // последняя задача - состязание с крадущими решает CAS по верхнему концу
+            if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                    std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    Job *JobDeque::steal() {
+        int64_t top = mTop.load(std::memory_order_seq_cst);
+        int64_t bottom = mBottom.load(std::memory_order_seq_cst);
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        Job *job = mJobs[top & (capacity - 1)].load(std::memory_order_relaxed);
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return job;
+    }
+
+    JobSystem::JobSystem(unsigned workers) : mOwner(std::this_thread::get_id()) {
+        for (unsigned i = 0; i != workers + 1; ++i) {
+            mDeques.push_back(std::make_unique<JobDeque>());
+        }
+        for (unsigned i = 0; i != workers; ++i) {
+            mWorkers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        mRunning.store(false);
+        {
+            std::lock_guard lock(mSleepMutex);
+            mWake.notify_all();
+        }
+        for (auto &worker : mWorkers) {
+            worker.join();
+        }
+
+        while (auto job = next(0)) {
+            execute(job);
+        }
+        for (auto job : mBackground) {
+            execute(job);
+        }
+    }
+
+    void JobSystem::run(JobCounter &counter, std::function<void()> task) {
+        auto job = new Job{std::move(task), &counter};
+        counter.mPending.fetch_add(1, std::memory_order_relaxed);
+
+        int index = currentIndex();
+        if (index < 0) {
+            std::lock_guard lock(mSharedMutex);
+            mShared.push_back(job);
+        } else if (!mDeques[index]->push(job)) {
+            execute(job);
+            return;
+        }
+
+        wake();
+    }
+
+    void JobSystem::runBackground(JobCounter &counter, std::function<void()> task) {
+        auto job = new Job{std::move(task), &counter};
+        counter.mPending.fetch_add(1, std::memory_order_relaxed);
+
+        if (mWorkers.empty()) {
+            execute(job);
+            return;
+        }
+        {
+            std::lock_guard lock(mSharedMutex);
+            mBackground.push_back(job);
+        }
+        wake();
+    }
+
+    void JobSystem::wake() {
+        // пара mQueued/mSleeping с seq_cst: либо засыпающий увидит задачу, либо здесь
+        // будет виден спящий
+        mQueued.fetch_add(1);
+        if (mSleeping.load() > 0) {
+            std::lock_guard lock(mSleepMutex);
+            mWake.notify_one();
+        }
+    }
+
+    void JobSystem::wait(JobCounter &counter) {
+        int index = currentIndex();
+        while (!counter.done()) {
+            if (auto job = next(index)) {
+                execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::waitBackground(JobCounter &counter) {
+        std::unique_lock lock(mDoneMutex);
+        // пара mBlocked/mPending с seq_cst, как mQueued/mSleeping в run: либо здесь будет
+        // виден ноль, либо execute увидит ждущий поток
+        mBlocked.fetch_add(1);
+        mDone.wait(lock, [&counter] { return counter.mPending.load() == 0; });
+        mBlocked.fetch_sub(1);
+    }
+
+    void JobSystem::work(unsigned index) {
+        tSystem = this;
+        tIndex = static_cast<int>(index) + 1;
+        tSeed += index * 0x85ebca6bu;
+
+        int idle = 0;
+        while (mRunning.load(std::memory_order_relaxed)) {
+            if (auto job = next(tIndex)) {
+                execute(job);
+                idle = 0;
+                continue;
+            }
+
+            if (++idle < spinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock lock(mSleepMutex);
+            mSleeping.fetch_add(1);
+            mWake.wait(lock, [this] { return mQueued.load() > 0 || !mRunning.load(); });
+            mSleeping.fetch_sub(1);
+            idle = 0;
+        }
+    }
+
+    Job *JobSystem::next(int index) {
+        Job *job = index >= 0 ? mDeques[index]->pop() : nullptr;
+
+        if (!job && mQueued.load(std::memory_order_relaxed) > 0) {
+            {
+                std::lock_guard lock(mSharedMutex);
+                if (!mShared.empty()) {
+                    job = mShared.back();
+                    mShared.pop_back();
+                }
+            }
+
+            auto count = static_cast<uint32_t>(mDeques.size());
+            uint32_t start = nextRandom() % count;
+            for (uint32_t i = 0; !job && i != count; ++i) {
+                uint32_t victim = (start + i) % count;
+                if (static_cast<int>(victim) != index) {
+                    job = mDeques[victim]->steal();
+                }
+            }
+
+            // фоновые задачи - только рабочим и только когда нет задач кадра
+            if (!job && index > 0) {
+                std::lock_guard lock(mSharedMutex);
+                if (!mBackground.empty()) {
+                    job = mBackground.front();
+                    mBackground.pop_front();
+                }
+            }
+        }
+
+        if (job) {
+            mQueued.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    void JobSystem::execute(Job *job) {
+        job->task();
+        // после обнуления счётчик может быть уже разрушен ждавшим его потоком
+        bool last = job->counter->mPending.fetch_sub(1) == 1;
+        delete job;
+        if (last && mBlocked.load() > 0) {
+            std::lock_guard lock(mDoneMutex);
+            mDone.notify_all();
+        }
+    }
+
+    int JobSystem::currentIndex() const {
+        if (tSystem == this) {
+            return tIndex;
+        }
+        return std::this_thread::get_id() == mOwner ? 0 : -1;
+    }
+}
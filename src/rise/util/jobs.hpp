@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+namespace rise {
+    struct Job;
+
+    // очередь Chase-Lev: владелец кладёт и забирает задачи с нижнего конца без блокировок,
+    // остальные потоки крадут с верхнего. Ёмкость фиксирована, при переполнении push
+    // возвращает false и задача выполняется на месте
+    class JobDeque {
+    public:
+        static constexpr int64_t capacity = 4096;
+
+        bool push(Job *job);
+
+        Job *pop();
+
+        Job *steal();
+
+    private:
+        alignas(64) std::atomic<int64_t> mTop{0};
+        alignas(64) std::atomic<int64_t> mBottom{0};
+        std::atomic<Job *> mJobs[capacity] = {};
+    };
+
+    // счётчик незавершённых задач для fork/join: run увеличивает, завершение задачи уменьшает
+    class JobCounter {
+    public:
+        bool done() const {
+            return mPending.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<uint32_t> mPending{0};
+    };
+
+    // рабочий поток на каждое ядро, кроме создавшего систему потока: у него своя очередь,
+    // и в wait он выполняет задачи вместе с рабочими
+    class JobSystem {
+    public:
+        explicit JobSystem(
+                unsigned workers = std::max(1u, std::thread::hardware_concurrency()) - 1);
+
+        ~JobSystem();
+
+        JobSystem(JobSystem const &) = delete;
+
+        JobSystem &operator=(JobSystem const &) = delete;
+
+        void run(JobCounter &counter, std::function<void()> task);
+
+        // долгая задача вроде загрузки файла: её берут только рабочие потоки, чтобы wait и
+        // parallelFor главного потока не застревали на ней посреди кадра. Задачи выполняются
+        // в порядке постановки, без рабочих потоков - на месте
+        void runBackground(JobCounter &counter, std::function<void()> task);
+
+        // до обнуления счётчика поток не спит, а выполняет свои и чужие задачи
+        void wait(JobCounter &counter);
+
+        // для счётчиков runBackground: поток спит до обнуления счётчика, не выполняя задач,
+        // и не занимает ядро на время долгой фоновой задачи
+        void waitBackground(JobCounter &counter);
+
+        // f(begin, end) для отрезков не длиннее grain, единственный отрезок выполняется
+        // на месте без постановки в очередь
+        template<typename F>
+        void parallelFor(size_t begin, size_t end, size_t grain, F &&f) {
+            grain = std::max<size_t>(1, grain);
+            if (end <= begin) {
+                return;
+            }
+            if (end - begin <= grain || mWorkers.empty()) {
+                f(begin, end);
+                return;
+            }
+
+            JobCounter counter;
+            for (size_t first = begin + grain; first < end; first += grain) {
+                size_t last = std::min(end, first + grain);
+                run(counter, [&f, first, last] { f(first, last); });
+            }
+            f(begin, begin + grain);
+            wait(counter);
+        }
+
+        unsigned workerCount() const {
+            return static_cast<unsigned>(mWorkers.size());
+        }
+
+    private:
+        void work(unsigned index);
+
+        Job *next(int index);
+
+        void execute(Job *job);
+
+        void wake();
+
+        int currentIndex() const;
+
+        // очередь 0 принадлежит создавшему потоку, очередь i + 1 - рабочему потоку i
+        std::vector<std::unique_ptr<JobDeque>> mDeques;
+        std::vector<std::thread> mWorkers;
+
+        // задачи из потоков, у которых нет своей очереди
+        std::mutex mSharedMutex;
+        std::vector<Job *> mShared;
+        std::deque<Job *> mBackground;
+
+        // обнуление счётчика будит потоки в waitBackground
+        std::atomic<uint32_t> mBlocked{0};
+        std::mutex mDoneMutex;
+        std::condition_variable mDone;
+
+        std::atomic<int32_t> mQueued{0};
+        std::atomic<uint32_t> mSleeping{0};
+        std::atomic<bool> mRunning{true};
+        std::mutex mSleepMutex;
+        std::condition_variable mWake;
+        std::thread::id mOwner;
+    };
+}
@@ -1,8 +1,14 @@
 #pragma once
 
 #include <tuple>
+#include <cassert>
+#include <vector>
+#include <memory>
+#include <type_traits>
 #include <SG14/slot_map.h>
 #include <limits>
+#include <algorithm>
+#include "span.hpp"
 
 namespace rise {
 
@@ -23,9 +29,26 @@ namespace rise {
     template<typename TContainer>
     class Iterator;
 
-    template<template<typename...> class Container, DataLayout TDataLayout, typename TItem>
+    template<template<typename...> class Container, DataLayout TDataLayout, typename TItem,
+            typename = void>
     struct DataLayoutPolicy;
 
+    // std::vector с заданным шаблоном аллокатора, для передачи как шаблонного параметра
+    template<template<typename> class TAllocator>
+    struct AllocatorVector {
+        template<typename T>
+        using type = std::vector<T, TAllocator<T>>;
+    };
+
+    template<typename T, template<typename> class TAllocator = std::allocator>
+    struct DefaultSlotMap;
+
+    template<typename T>
+    struct IsSlotMap : std::false_type {};
+
+    template<typename T, template<typename> class TAllocator>
+    struct IsSlotMap<DefaultSlotMap<T, TAllocator>> : std::true_type {};
+
     template<template<typename...> class Container,
             template<typename...> class TItem, typename... Types>
     struct DataLayoutPolicy<Container, DataLayout::AoS, TItem<Types...>> {
@@ -47,7 +70,8 @@ namespace rise {
 
     template<template<typename...> class Container,
             template<typename...> class TItem, typename... Types>
-    struct DataLayoutPolicy<Container, DataLayout::SoA, TItem<Types...>> {
+    struct DataLayoutPolicy<Container, DataLayout::SoA, TItem<Types...>,
+            std::enable_if_t<!IsSlotMap<Container<char>>::value>> {
         using Key = size_t;
         using type = std::tuple<Container<Types>...>;
         using value_type = TItem<ref_wrap<Types>...>;
@@ -70,8 +94,42 @@ namespace rise {
 
         static constexpr std::size_t size(type &c_) { return std::get<0>(c_).size(); }
 
+        // все колонки с копиями одного аллокатора, приведёнными к типу колонки
+        template<typename TAllocator>
+        static type make(TAllocator const &allocator_) {
+            return type{Container<Types>(typename std::allocator_traits<TAllocator>::
+                    template rebind_alloc<Types>(allocator_))...};
+        }
+
+        template<unsigned I>
+        static auto column(type &c_) {
+            auto &values = std::get<I>(c_);
+            return Span<std::tuple_element_t<I, std::tuple<Types...>>>(values.data(),
+                    values.size());
+        }
+
+        template<typename F>
+        static void for_each_chunk(type &c_, size_t chunk_, F &&f_) {
+            doForEachChunk(c_, chunk_, f_,
+                    std::make_integer_sequence<unsigned, sizeof...(Types)>());
+        }
+
     private:
 
+        template<typename F, unsigned... Ids>
+        static void
+        doForEachChunk(type &c_, size_t chunk_, F &f_, std::integer_sequence<unsigned, Ids...>) {
+            // при нулевом отрезке first не растёт и цикл не завершается
+            assert(chunk_ != 0 && "Chunk size must be positive");
+            chunk_ = std::max<size_t>(1, chunk_);
+            auto columns = std::tuple{column<Ids>(c_)...};
+            size_t total = size(c_);
+            for (size_t first = 0; first < total; first += chunk_) {
+                size_t count = std::min(chunk_, total - first);
+                f_(std::get<Ids>(columns).subspan(first, count)...);
+            }
+        }
+
         template<unsigned... Ids>
         constexpr static auto
         doGet(type &c_, Key position_, std::integer_sequence<unsigned, Ids...>) {
@@ -92,18 +150,22 @@ namespace rise {
         }
     };
 
-    template<typename T>
-    struct DefaultSlotMap : stdext::slot_map<T> {
+    // slot_map не принимает экземпляр аллокатора, поэтому TAllocator создаётся по умолчанию
+    template<typename T, template<typename> class TAllocator>
+    struct DefaultSlotMap : stdext::slot_map<T, std::pair<unsigned, unsigned>,
+            AllocatorVector<TAllocator>::template type> {
         auto push_back(T val) {
-            return stdext::slot_map<T>::insert(val);
+            return this->insert(val);
         }
 
     };
 
-    template<template<typename...> class TItem, typename... Types>
-    struct DataLayoutPolicy<DefaultSlotMap, DataLayout::SoA, TItem<Types...>> {
+    template<template<typename...> class Container,
+            template<typename...> class TItem, typename... Types>
+    struct DataLayoutPolicy<Container, DataLayout::SoA, TItem<Types...>,
+            std::enable_if_t<IsSlotMap<Container<char>>::value>> {
         using Key = std::pair<unsigned, unsigned>;
-        using type = std::tuple<DefaultSlotMap<Types>...>;
+        using type = std::tuple<Container<Types>...>;
         using value_type = TItem<ref_wrap<Types>...>;
 
         constexpr static value_type get(type &c_, size_t position_) {
@@ -139,8 +201,37 @@ namespace rise {
 
         static constexpr std::size_t size(type &c_) { return std::get<0>(c_).size(); }
 
+        // все колонки вставляются и удаляются одинаково, поэтому плотные массивы значений
+        // идут в одном порядке. Порядок не совпадает с индексами слотов в operator[]
+        template<unsigned I>
+        static auto column(type &c_) {
+            auto &values = std::get<I>(c_);
+            using T = std::tuple_element_t<I, std::tuple<Types...>>;
+            return values.size() ? Span<T>(&*values.begin(), values.size()) : Span<T>();
+        }
+
+        template<typename F>
+        static void for_each_chunk(type &c_, size_t chunk_, F &&f_) {
+            doForEachChunk(c_, chunk_, f_,
+                    std::make_integer_sequence<unsigned, sizeof...(Types)>());
+        }
+
     private:
 
+        template<typename F, unsigned... Ids>
+        static void
+        doForEachChunk(type &c_, size_t chunk_, F &f_, std::integer_sequence<unsigned, Ids...>) {
+            // при нулевом отрезке first не растёт и цикл не завершается
+            assert(chunk_ != 0 && "Chunk size must be positive");
+            chunk_ = std::max<size_t>(1, chunk_);
+            auto columns = std::tuple{column<Ids>(c_)...};
+            size_t total = size(c_);
+            for (size_t first = 0; first < total; first += chunk_) {
+                size_t count = std::min(chunk_, total - first);
+                f_(std::get<Ids>(columns).subspan(first, count)...);
+            }
+        }
+
         template<unsigned... Ids>
         constexpr static auto
         doGet(type &c_, size_t position_, std::integer_sequence<unsigned, Ids...>) {
@@ -201,6 +292,11 @@ namespace rise {
             resize(size_);
         }
 
+        // только для SoaVector: колонки получают копии allocator_, например с общей ареной
+        template<typename TAllocator, typename = typename TAllocator::value_type>
+        explicit BaseContainer(TAllocator const &allocator_) :
+                mValues(mpolicy_t::make(allocator_)) {}
+
         template<typename Fwd>
         auto push_back(Fwd &&val) {
             return mpolicy_t::push_back(mValues, std::forward<Fwd>(val));
@@ -231,6 +327,20 @@ namespace rise {
             mpolicy_t::resize(mValues, size_);
         }
 
+        // плотный массив одного поля: простой цикл по нему компилятор может векторизовать
+        template<unsigned I>
+        auto column() {
+            return mpolicy_t::template column<I>(mValues);
+        }
+
+        // f(span0, span1, ...) для последовательных отрезков по chunk_ элементов во всех колонках,
+        // каждый отрезок начинается с индекса, кратного chunk_. Выровнен только индекс: адрес
+        // начала колонки выбирает аллокатор, так что SIMD загрузки должны быть невыровненными
+        template<typename F>
+        void for_each_chunk(size_t chunk_, F &&f_) {
+            mpolicy_t::for_each_chunk(mValues, chunk_, std::forward<F>(f_));
+        }
+
         iterator begin() { return iterator(this, 0); }
 
         iterator end() { return iterator(this, size()); }
@@ -308,12 +418,25 @@ namespace rise {
     template<typename T>
     using DefaultVector = std::vector<T, std::allocator<T>>;
 
+    template<template<typename> class TAllocator>
+    struct AllocatorSlotMap {
+        template<typename T>
+        using type = DefaultSlotMap<T, TAllocator>;
+    };
+
+    template<template<typename> class TAllocator, typename... Types>
+    using BasicSoaVector = BaseContainer<AllocatorVector<TAllocator>::template type,
+            DataLayout::SoA, std::tuple<Types...>>;
+
+    template<template<typename> class TAllocator, typename... Types>
+    using BasicSoaSlotMap = BaseContainer<AllocatorSlotMap<TAllocator>::template type,
+            DataLayout::SoA, std::tuple<Types...>>;
 
     template<typename... Types>
-    using SoaVector = BaseContainer<DefaultVector, DataLayout::SoA, std::tuple<Types...>>;
+    using SoaVector = BasicSoaVector<std::allocator, Types...>;
 
     template<typename... Types>
-    using SoaSlotMap = BaseContainer<DefaultSlotMap, DataLayout::SoA, std::tuple<Types...>>;
+    using SoaSlotMap = BasicSoaSlotMap<std::allocator, Types...>;
 
     // id + version
     using Key = std::pair<unsigned, unsigned>;
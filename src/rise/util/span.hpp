@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+namespace rise {
+    // непрерывный диапазон без владения, пока проект собирается как C++17 вместо std::span
+    template<typename T>
+    class Span {
+    public:
+        using value_type = T;
+        using iterator = T *;
+
+        Span() = default;
+
+        Span(T *data, size_t size) : mData(data), mSize(size) {}
+
+        T *data() const { return mData; }
+
+        size_t size() const { return mSize; }
+
+        bool empty() const { return mSize == 0; }
+
+        T &operator[](size_t position) const { return mData[position]; }
+
+        T *begin() const { return mData; }
+
+        T *end() const { return mData + mSize; }
+
+        Span subspan(size_t offset, size_t count) const {
+            return {mData + offset, count};
+        }
+
+    private:
+        T *mData = nullptr;
+        size_t mSize = 0;
+    };
+}